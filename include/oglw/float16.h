@@ -1,29 +1,98 @@
 #ifndef OGLW_FLOAT16_H_190330
 #define OGLW_FLOAT16_H_190330
 
+#include <cstdint>
+#include <cstring>
+
 namespace oglw {
 
-// ------------------------------ Dummy Half float -----------------------------
-// Just wrap float32 for CPU
+// ------------------------------ Half conversion ------------------------------
+// IEEE 754 binary16 <-> binary32. Rounded to nearest even, and overflow goes
+// to infinity. NaN is kept as quiet NaN.
+inline uint16_t FloatToHalfBits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    const uint32_t sign = (u >> 16) & 0x8000u;
+    u &= 0x7fffffffu;
+
+    uint16_t bits;
+    if (0x47800000u <= u) {
+        // Infinity or NaN (not smaller than 2^16)
+        bits = (0x7f800000u < u) ? 0x7e00u : 0x7c00u;
+    } else if (u < 0x38800000u) {
+        // Subnormal or zero (smaller than 2^-14). Align the mantissa to the
+        // bottom with float addition, which rounds to nearest even.
+        const uint32_t magic_u = 0x3f000000u;  // 0.5f
+        float magic_f, v;
+        std::memcpy(&magic_f, &magic_u, sizeof(magic_f));
+        std::memcpy(&v, &u, sizeof(v));
+        v += magic_f;
+        std::memcpy(&u, &v, sizeof(u));
+        bits = static_cast<uint16_t>(u - magic_u);
+    } else {
+        // Normal. Rebias the exponent and round to nearest even.
+        const uint32_t mant_odd = (u >> 13) & 1u;
+        u += 0xc8000fffu + mant_odd;
+        bits = static_cast<uint16_t>(u >> 13);
+    }
+    return static_cast<uint16_t>(bits | sign);
+}
+
+inline float HalfBitsToFloat(uint16_t bits) {
+    const uint32_t shifted_exp = 0x7c00u << 13;
+    uint32_t u = (bits & 0x7fffu) << 13;
+    const uint32_t exp = u & shifted_exp;
+    u += (127u - 15u) << 23;  // Rebias the exponent
+    float f;
+    if (exp == shifted_exp) {
+        // Infinity or NaN
+        u += (128u - 16u) << 23;
+        std::memcpy(&f, &u, sizeof(f));
+    } else if (exp == 0) {
+        // Subnormal or zero. Renormalize with float subtraction.
+        const uint32_t magic_u = 113u << 23;  // 2^-14
+        float magic_f;
+        std::memcpy(&magic_f, &magic_u, sizeof(magic_f));
+        u += 1u << 23;
+        std::memcpy(&f, &u, sizeof(f));
+        f -= magic_f;
+        std::memcpy(&u, &f, sizeof(u));
+    }
+    u |= static_cast<uint32_t>(bits & 0x8000u) << 16;  // Sign
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// --------------------------------- Half float --------------------------------
+// 2-byte storage of IEEE half float. Arithmetic is done in float32.
 class Float16 {
 public:
     Float16() {}
-    Float16(float v_) : v(v_) {}
-    Float16 operator += (Float16 lhs) { v += lhs.v; return *this; }
-    Float16 operator -= (Float16 lhs) { v -= lhs.v; return *this; }
-    Float16 operator *= (Float16 lhs) { v *= lhs.v; return *this; }
-    Float16 operator /= (Float16 lhs) { v /= lhs.v; return *this; }
-    Float16 operator + (Float16 lhs) const { return Float16(v + lhs.v); }
-    Float16 operator - (Float16 lhs) const { return Float16(v - lhs.v); }
-    Float16 operator * (Float16 lhs) const { return Float16(v * lhs.v); }
-    Float16 operator / (Float16 lhs) const { return Float16(v / lhs.v); }
-    Float16 operator - () const { return Float16(-v); }
-    bool operator == (Float16 lhs) const { return v == lhs.v; }
-    bool operator != (Float16 lhs) const { return v != lhs.v; }
-
-    float v;
+    Float16(float v) : bits(FloatToHalfBits(v)) {}
+    explicit operator float() const { return HalfBitsToFloat(bits); }
+
+    static Float16 FromBits(uint16_t b) { Float16 h; h.bits = b; return h; }
+
+    Float16 operator += (Float16 lhs) { return *this = *this + lhs; }
+    Float16 operator -= (Float16 lhs) { return *this = *this - lhs; }
+    Float16 operator *= (Float16 lhs) { return *this = *this * lhs; }
+    Float16 operator /= (Float16 lhs) { return *this = *this / lhs; }
+    Float16 operator + (Float16 lhs) const { return Float16(f() + lhs.f()); }
+    Float16 operator - (Float16 lhs) const { return Float16(f() - lhs.f()); }
+    Float16 operator * (Float16 lhs) const { return Float16(f() * lhs.f()); }
+    Float16 operator / (Float16 lhs) const { return Float16(f() / lhs.f()); }
+    Float16 operator - () const { return Float16(-f()); }
+    bool operator == (Float16 lhs) const { return f() == lhs.f(); }
+    bool operator != (Float16 lhs) const { return f() != lhs.f(); }
+
+    uint16_t bits;
+
+private:
+    float f() const { return HalfBitsToFloat(bits); }
 };
 
+static_assert(sizeof(Float16) == 2, "Float16 must be 2 bytes");
+
 }  // namespace oglw
 
 #endif /* end of include guard */
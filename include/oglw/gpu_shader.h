@@ -46,6 +46,14 @@ public:
     void setUniform(const std::string& name, const GpuImage<T>& gpu_img) {
         setUniform(name, gpu_img.getTextureId());
     }
+    template <typename T>
+    void setUniform(const std::string& name, const GpuImageArray<T>& gpu_img) {
+        setUniform(name, gpu_img.getTextureId());
+    }
+    template <typename T>
+    void setUniform(const std::string& name, const GpuImage3D<T>& gpu_img) {
+        setUniform(name, gpu_img.getTextureId());
+    }
 
     void use() const;
 
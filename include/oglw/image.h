@@ -1,10 +1,18 @@
 #ifndef OGLW_IMAGE_H_190205
 #define OGLW_IMAGE_H_190205
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <oglw/float16.h>
+#include <oglw/parallel.h>
 
 namespace oglw {
 
@@ -14,7 +22,17 @@ class GpuImageBase;
 template <typename T>
 class CpuImage;
 template <typename T>
+class CpuImageView;
+template <typename T>
 class GpuImage;
+template <typename T>
+class GpuReadback;
+template <typename T>
+class GpuUploadRing;
+template <typename T>
+class GpuImageArray;
+template <typename T>
+class GpuImage3D;
 
 // ------------------------------ Pointer Aliases ------------------------------
 using ImageBasePtr = std::shared_ptr<ImageBase>;
@@ -24,6 +42,10 @@ template <typename T>
 using GpuImagePtr = std::shared_ptr<GpuImage<T>>;
 template <typename T>
 using CpuImagePtr = std::shared_ptr<CpuImage<T>>;
+template <typename T>
+using GpuImageArrayPtr = std::shared_ptr<GpuImageArray<T>>;
+template <typename T>
+using GpuImage3DPtr = std::shared_ptr<GpuImage3D<T>>;
 
 
 // ================================= Image Base ================================
@@ -65,7 +87,82 @@ public:
     virtual int getTextureId() const = 0;
 };
 
+// ================================ Image Format ===============================
+enum class ImageFormat {
+    AUTO,    // From the file extension (JPEG for unknown ones)
+    JPEG,
+    PNG,
+    BMP,
+    TGA,
+    PFM,     // Portable float map (1 or 3 channels, integers mapped to [0, 1])
+    RAW,     // Values of `T` as they are, from the bottom row, without header
+    NATIVE,  // Header and pixels as in memory (.oglw), which can be mapped
+};
+
+enum class ImageMapMode {
+    READ_ONLY,      // Mutable access clones the pixels
+    COPY_ON_WRITE,  // Written pages are private copies
+};
+
+struct ImageSaveOptions {
+    ImageFormat format = ImageFormat::AUTO;
+    int jpeg_quality = 90;    // 1 - 100
+    int png_compression = 8;  // zlib level 0 (fastest) - 9 (smallest)
+};
+
+// ================================ Image Layout ===============================
+enum class ImageLayout {
+    INTERLEAVED,  // `at(x, y, z)` is `data()[y * row_stride + x * d + z]`
+    PLANAR,       // `at(x, y, z)` is `data()[(z * h + y) * row_stride + x]`
+};
+
+// ================================== Mipmap ===================================
+// Sampling filters of GPU textures. Mipmap ones are for minification only.
+enum class TextureFilter {
+    NEAREST,
+    LINEAR,
+    NEAREST_MIPMAP_NEAREST,
+    LINEAR_MIPMAP_NEAREST,
+    NEAREST_MIPMAP_LINEAR,
+    LINEAR_MIPMAP_LINEAR,  // Trilinear
+};
+
+// Size of mip `level` on one axis (halved and floored, at least 1)
+inline size_t GetMipSize(size_t size, size_t level) {
+    return std::max(size >> std::min(level, size_t(63)), size_t(1));
+}
+
+// Number of levels of the full chain, down to 1x1
+inline size_t GetMipLevelCount(size_t w, size_t h) {
+    size_t n_level = 1;
+    for (size_t size = std::max(w, h); 1 < size; size >>= 1) {
+        n_level++;
+    }
+    return n_level;
+}
+
+// ================================ Foreach Tile ===============================
+// Tile size (pixels) which `CpuImage::foreach` hands to each task.
+// 0 means automatic: tiles of about `FOREACH_TILE_BYTES`, preferring whole
+// rows. The width is rounded up so that tiles start on cache lines of a row.
+struct ForeachTile {
+    size_t w = 0;
+    size_t h = 0;
+};
+
+// ================================= Image Rect ================================
+struct ImageRect {
+    size_t x = 0;
+    size_t y = 0;
+    size_t w = 0;
+    size_t h = 0;
+};
+
 // ================================= CPU Image =================================
+// Copies share the pixels until one of them is accessed mutably (data(), at(),
+// view() or foreach() of non-const image), which clones them (copy-on-write).
+// Pointers and references obtained before a copy keep pointing to the shared
+// pixels. Once a mutable view is taken, copies get their own pixels.
 template <typename T>
 class CpuImage : public CpuImageBase {
 public:
@@ -78,6 +175,8 @@ public:
 
     CpuImage();
     CpuImage(size_t w, size_t h, size_t d);
+    CpuImage(size_t w, size_t h, size_t d, size_t row_align,
+             ImageLayout layout = ImageLayout::INTERLEAVED);
 
     CpuImage(const CpuImage&);
     CpuImage(CpuImage&&);
@@ -89,34 +188,473 @@ public:
     void fromGpu(const GpuImagePtr<T>& gpu_img);
     void fromGpu(const GpuImage<T>& gpu_img);
 
+    // Convert each value as `v * scale + bias` into a new dense image of the
+    // same layout. Conversion to uint8_t is rounded and clamped to [0, 255].
+    // (e.g. `convertTo<float>(1.f / 255.f)` normalizes 8-bit pixels)
+    // `U` is one of uint8_t, uint16_t, float and Float16.
+    template <typename U>
+    CpuImagePtr<U> convertTo(float scale = 1.f, float bias = 0.f) const;
+
     virtual void init(size_t w, size_t h, size_t d) override;
     virtual bool empty() const override;
     virtual size_t getWidth() const override;
     virtual size_t getHeight() const override;
     virtual size_t getDepth() const override;
 
+    // Pad each row to start on `row_align` bytes (power of two, up to 64).
+    // `row_align == 0` packs rows densely, which is the default.
+    // Planar images have a plane of `h` rows for each channel.
+    void init(size_t w, size_t h, size_t d, size_t row_align,
+              ImageLayout layout = ImageLayout::INTERLEAVED);
+    size_t getRowStride() const;  // Number of elements between rows
+    ImageLayout getLayout() const;
+    // Rearrange the pixels in parallel. Loaded and GPU images are interleaved,
+    // and planar ones are interleaved temporarily to save or upload.
+    void setLayout(ImageLayout layout);
+
+    // Native files (.oglw) of the same type are mapped with copy-on-write
+    // instead of being read, and others are converted.
     virtual void load(const std::string& filename) override;
+    // Same as above, converting pixels on `n_worker` workers.
+    // (0: automatic, 1: only in the calling thread)
+    void load(const std::string& filename, size_t n_worker);
+    // Map a native file of the same type without copy. The file is never
+    // modified through the image.
+    void map(const std::string& filename,
+             ImageMapMode mode = ImageMapMode::READ_ONLY);
     virtual void save(const std::string& filename) const override;
+    // 8-bit formats are rounded from the normalized range of `T`.
+    void save(const std::string& filename,
+              const ImageSaveOptions& options) const;
 
     const T* data() const;
     T* data();
     const T& at(size_t x, size_t y, size_t z) const;
     T& at(size_t x, size_t y, size_t z);
 
+    // Zero-copy view of the whole image or the rectangle from (x, y).
+    // (See `CpuImageView`) Only for interleaved images.
+    CpuImageView<T> view();
+    CpuImageView<const T> view() const;
+    CpuImageView<T> view(size_t x, size_t y, size_t w, size_t h);
+    CpuImageView<const T> view(size_t x, size_t y, size_t w, size_t h) const;
+
+    // Regions written since the last upload by `GpuImage::fromCpu()`, which
+    // then uploads only them if its texture was last uploaded from this
+    // image. Mutable `at()` and `view(x, y, w, h)` mark their tiles, and the
+    // other mutable accesses (e.g. `data()`, `foreach()`) the whole image.
+    // Marks are atomic, so mutable accesses may run in parallel unless the
+    // image is uploaded or cleared meanwhile. Writes through pointers or views
+    // taken before an upload are not tracked without `markDirty()`.
+    void markDirty();
+    void markDirty(size_t x, size_t y, size_t w, size_t h);
+    void clearDirty();
+    bool isDirty() const;
+    // Dirty tiles merged into rectangles
+    std::vector<ImageRect> getDirtyRects() const;
+
+    // Pixels are visited tile by tile in parallel. (See `ForeachTile`)
+    // With `n_worker == 1`, they are visited in raster order (plane by plane
+    // for planar images, which do not support `channel_vs`). Images of
+    // `PARALLEL_PINNED_BYTES` or more without `n_worker` and `tile` are
+    // visited by row bands of `ParallelForPinned()`, as they were allocated.
     void foreach (std::function<void(size_t x, size_t y, size_t z, T& v)>,
-                  size_t n_worker = 0);
+                  size_t n_worker = 0, ForeachTile tile = {});
     void foreach (std::function<void(size_t x, size_t y, size_t z, const T& v)>,
-                  size_t n_worker = 0) const;
+                  size_t n_worker = 0, ForeachTile tile = {}) const;
     void foreach (std::function<void(size_t x, size_t y, T* channel_vs)>,
-                  size_t n_worker = 0);
+                  size_t n_worker = 0, ForeachTile tile = {});
     void foreach (std::function<void(size_t x, size_t y, const T* channel_vs)>,
-                  size_t n_worker = 0) const;
+                  size_t n_worker = 0, ForeachTile tile = {}) const;
+
+    // Inlinable versions of above. `func` is any callable of
+    // `(x, y, z, v)` or `(x, y, channel_vs)`, and is expanded in the row loop.
+    template <typename F>
+    void foreach (F func, size_t n_worker = 0, ForeachTile tile = {});
+    template <typename F>
+    void foreach (F func, size_t n_worker = 0, ForeachTile tile = {}) const;
+
+    // Call `func(y, z, row)` for each row in memory in parallel. A row is
+    // `w` values of channel `z` for planar images, and `w * d` values of all
+    // channels (`z == 0`) for interleaved ones.
+    template <typename F>
+    void foreachRow(F func, size_t n_worker = 0);
+    template <typename F>
+    void foreachRow(F func, size_t n_worker = 0) const;
 
 private:
+    template <typename U>
+    friend class CpuImageView;
+    friend class GpuImage<T>;
+
+    // Identifier of the last upload, which is renewed with clearing dirty
+    // tiles by `markSynced()` (0: never uploaded)
+    uint64_t getSyncId() const;
+    uint64_t markSynced();
+
+    static ForeachTile GetForeachTile(size_t w, size_t h, size_t d,
+                                      ForeachTile tile);
+    template <typename V, typename F>
+    static void ForeachPixels(V* data, size_t w, size_t h, size_t d,
+                              size_t stride, ImageLayout layout, F& func,
+                              size_t n_worker, ForeachTile tile);
+    template <typename V, typename F>
+    static void ForeachPlanes(V* data, size_t w, size_t h, size_t d,
+                              size_t stride, F& func, size_t n_worker,
+                              ForeachTile tile,
+                              std::true_type /* channel-wise */);
+    template <typename V, typename F>
+    static void ForeachPlanes(V* data, size_t w, size_t h, size_t d,
+                              size_t stride, F& func, size_t n_worker,
+                              ForeachTile tile,
+                              std::false_type /* pixel-wise */);
+    template <typename V, typename F>
+    static void ForeachRowPtrs(V* data, size_t w, size_t h, size_t d,
+                               size_t stride, ImageLayout layout, F& func,
+                               size_t n_worker);
+    template <typename V, typename F>
+    static void ForeachTiles(V* data, size_t w, size_t h, size_t d,
+                             size_t stride, F& func, size_t n_worker,
+                             ForeachTile tile);
+    template <typename V, typename F>
+    static void ForeachRow(V* row, size_t x_begin, size_t x_end, size_t y,
+                           size_t d, F& func,
+                           std::true_type /* channel-wise */);
+    template <typename V, typename F>
+    static void ForeachRow(V* row, size_t x_begin, size_t x_end, size_t y,
+                           size_t d, F& func,
+                           std::false_type /* pixel-wise */);
+
     class Impl;
     std::unique_ptr<Impl> m_impl;
 };
 
+// --------------------------- CPU Image (templates) ---------------------------
+// Images with fewer values are processed in the calling thread by default
+constexpr size_t FOREACH_INLINE_SIZE = 16 * 1024;
+constexpr size_t FOREACH_TILE_BYTES = 64 * 1024;
+constexpr size_t FOREACH_CACHE_LINE = 64;
+
+// Whether `F` is called as `(x, y, z, v)` (otherwise `(x, y, channel_vs)`)
+template <typename F, typename V, typename = void>
+struct IsChannelForeachFunc : std::false_type {};
+
+template <typename F, typename V>
+struct IsChannelForeachFunc<
+        F, V,
+        decltype(std::declval<F&>()(size_t(), size_t(), size_t(),
+                                    std::declval<V&>()),
+                 void())> : std::true_type {};
+
+template <typename T>
+template <typename F>
+void CpuImage<T>::foreach (F func, size_t n_worker, ForeachTile tile) {
+    ForeachPixels(data(), getWidth(), getHeight(), getDepth(), getRowStride(),
+                  getLayout(), func, n_worker, tile);
+}
+
+template <typename T>
+template <typename F>
+void CpuImage<T>::foreach (F func, size_t n_worker, ForeachTile tile) const {
+    ForeachPixels(data(), getWidth(), getHeight(), getDepth(), getRowStride(),
+                  getLayout(), func, n_worker, tile);
+}
+
+template <typename T>
+template <typename F>
+void CpuImage<T>::foreachRow(F func, size_t n_worker) {
+    ForeachRowPtrs(data(), getWidth(), getHeight(), getDepth(), getRowStride(),
+                   getLayout(), func, n_worker);
+}
+
+template <typename T>
+template <typename F>
+void CpuImage<T>::foreachRow(F func, size_t n_worker) const {
+    ForeachRowPtrs(data(), getWidth(), getHeight(), getDepth(), getRowStride(),
+                   getLayout(), func, n_worker);
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachPixels(V* data, size_t w, size_t h, size_t d,
+                                size_t stride, ImageLayout layout, F& func,
+                                size_t n_worker, ForeachTile tile) {
+    if (layout == ImageLayout::PLANAR) {
+        ForeachPlanes(data, w, h, d, stride, func, n_worker, tile,
+                      IsChannelForeachFunc<F, V>());
+    } else {
+        ForeachTiles(data, w, h, d, stride, func, n_worker, tile);
+    }
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachPlanes(V* data, size_t w, size_t h, size_t d,
+                                size_t stride, F& func, size_t n_worker,
+                                ForeachTile tile, std::true_type) {
+    if (n_worker == 0 && tile.w == 0 && tile.h == 0 &&
+        PARALLEL_PINNED_BYTES <= stride * h * d * sizeof(V) &&
+        HasParallelAffinity()) {
+        // Bands of rows through planes (as first touched)
+        ParallelForPinned(h * d, [&](size_t r_begin, size_t r_end) {
+            for (size_t r = r_begin; r < r_end; r++) {
+                const size_t z = r / h;
+                auto plane_func = [&func, z](size_t x, size_t y, size_t,
+                                             V& v) { func(x, y, z, v); };
+                ForeachRow(data + r * stride, 0, w, r % h, 1, plane_func,
+                           std::true_type());
+            }
+        });
+        return;
+    }
+    // Visit each plane as a single channel image
+    if (n_worker == 0 && w * h * d < FOREACH_INLINE_SIZE) {
+        n_worker = 1;
+    }
+    for (size_t z = 0; z < d; z++) {
+        auto plane_func = [&func, z](size_t x, size_t y, size_t, V& v) {
+            func(x, y, z, v);
+        };
+        ForeachTiles(data + z * h * stride, w, h, 1, stride, plane_func,
+                     n_worker, tile);
+    }
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachPlanes(V*, size_t, size_t, size_t, size_t, F&,
+                                size_t, ForeachTile, std::false_type) {
+    throw std::runtime_error("Planar image has no channel pointer to foreach");
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachRowPtrs(V* data, size_t w, size_t h, size_t d,
+                                 size_t stride, ImageLayout layout, F& func,
+                                 size_t n_worker) {
+    const size_t n_plane = (layout == ImageLayout::PLANAR) ? d : 1;
+    if (n_worker == 0 && w * h * d < FOREACH_INLINE_SIZE) {
+        n_worker = 1;
+    }
+    auto row_func = [&](size_t r_begin, size_t r_end) {
+        for (size_t r = r_begin; r < r_end; r++) {
+            func(r % h, r / h, data + r * stride);
+        }
+    };
+    if (n_worker == 0 &&
+        PARALLEL_PINNED_BYTES <= stride * h * n_plane * sizeof(V) &&
+        HasParallelAffinity()) {
+        ParallelForPinned(h * n_plane, row_func);
+    } else {
+        ParallelFor(h * n_plane, row_func, n_worker);
+    }
+}
+
+template <typename T>
+ForeachTile CpuImage<T>::GetForeachTile(size_t w, size_t h, size_t d,
+                                        ForeachTile tile) {
+    // Width unit whose bytes are a multiple of cache line
+    const size_t pix_bytes = std::max(d, size_t(1)) * sizeof(T);
+    size_t unit = 1;
+    while (unit * pix_bytes % FOREACH_CACHE_LINE != 0 &&
+           unit < FOREACH_CACHE_LINE) {
+        unit <<= 1;
+    }
+    // Split by bytes
+    if (tile.w == 0) {
+        tile.w = std::max(FOREACH_TILE_BYTES / pix_bytes, size_t(1));
+    }
+    tile.w = (tile.w + unit - 1) / unit * unit;
+    tile.w = std::min(tile.w, w);
+    if (tile.h == 0) {
+        tile.h = FOREACH_TILE_BYTES / std::max(tile.w * pix_bytes, size_t(1));
+    }
+    tile.h = std::min(std::max(tile.h, size_t(1)), h);
+    return tile;
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachTiles(V* data, size_t w, size_t h, size_t d,
+                               size_t stride, F& func, size_t n_worker,
+                               ForeachTile tile) {
+    if (w == 0 || h == 0) {
+        return;
+    }
+    if (n_worker == 0 && tile.w == 0 && tile.h == 0 &&
+        PARALLEL_PINNED_BYTES <= stride * h * sizeof(V) &&
+        HasParallelAffinity()) {
+        // Bands of rows (as first touched)
+        ParallelForPinned(h, [&](size_t y_begin, size_t y_end) {
+            for (size_t y = y_begin; y < y_end; y++) {
+                ForeachRow(data + y * stride, 0, w, y, d, func,
+                           IsChannelForeachFunc<F, V>());
+            }
+        });
+        return;
+    }
+    if (n_worker == 0 && w * h * d < FOREACH_INLINE_SIZE) {
+        n_worker = 1;
+    }
+    if (n_worker == 1) {
+        // Whole image as one tile
+        tile.w = w;
+        tile.h = h;
+    } else {
+        tile = GetForeachTile(w, h, d, tile);
+    }
+    const size_t n_tile_x = (w + tile.w - 1) / tile.w;
+    const size_t n_tile_y = (h + tile.h - 1) / tile.h;
+    ParallelFor(n_tile_x * n_tile_y,
+                [&](size_t t_begin, size_t t_end) {
+                    for (size_t t = t_begin; t < t_end; t++) {
+                        const size_t x_begin = (t % n_tile_x) * tile.w;
+                        const size_t x_end = std::min(x_begin + tile.w, w);
+                        const size_t y_begin = (t / n_tile_x) * tile.h;
+                        const size_t y_end = std::min(y_begin + tile.h, h);
+                        for (size_t y = y_begin; y < y_end; y++) {
+                            ForeachRow(data + y * stride, x_begin, x_end, y, d,
+                                       func, IsChannelForeachFunc<F, V>());
+                        }
+                    }
+                },
+                n_worker);
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachRow(V* row, size_t x_begin, size_t x_end, size_t y,
+                             size_t d, F& func, std::true_type) {
+    row += x_begin * d;
+    for (size_t x = x_begin; x < x_end; x++) {
+        for (size_t z = 0; z < d; z++) {
+            func(x, y, z, *row++);
+        }
+    }
+}
+
+template <typename T>
+template <typename V, typename F>
+void CpuImage<T>::ForeachRow(V* row, size_t x_begin, size_t x_end, size_t y,
+                             size_t d, F& func, std::false_type) {
+    row += x_begin * d;
+    for (size_t x = x_begin; x < x_end; x++, row += d) {
+        func(x, y, row);
+    }
+}
+
+// ================================ Batch Load =================================
+// Load `filenames` concurrently on the thread pool, on at most `n_worker`
+// workers at a time (0: all). Files are taken in order, and the next ones are
+// read ahead while decoding. Failed ones are nullptr, whose messages are set
+// to `errors` if given. (empty for succeeded ones)
+template <typename T>
+std::vector<CpuImagePtr<T>> LoadImages(
+        const std::vector<std::string>& filenames,
+        std::vector<std::string>* errors = nullptr, size_t n_worker = 0);
+
+// ============================== CPU Image View ===============================
+// Rectangle of a CpuImage which shares its pixels without copy. The pixels are
+// kept alive by the view, even after the image is modified or destructed.
+// Views of non-const images are taken after the copy-on-write clone, so
+// writing through them changes only the image.
+// `T` is const-qualified for views of const images.
+template <typename T>
+class CpuImageView {
+public:
+    using ValueType = std::remove_const_t<T>;
+
+    CpuImageView() {}
+    CpuImageView(std::shared_ptr<const void> owner, T* data, size_t w,
+                 size_t h, size_t d, size_t row_stride)
+        : m_owner(std::move(owner)),
+          m_data(data),
+          m_w(w),
+          m_h(h),
+          m_d(d),
+          m_stride(row_stride) {}
+
+    // Mutable views are also const ones
+    template <typename U, typename = std::enable_if_t<
+                                  std::is_same<const U, T>::value>>
+    CpuImageView(const CpuImageView<U>& lhs)
+        : CpuImageView(lhs.m_owner, lhs.m_data, lhs.m_w, lhs.m_h, lhs.m_d,
+                       lhs.m_stride) {}
+
+    bool empty() const {
+        return m_w == 0 || m_h == 0 || m_d == 0;
+    }
+    size_t getWidth() const {
+        return m_w;
+    }
+    size_t getHeight() const {
+        return m_h;
+    }
+    size_t getDepth() const {
+        return m_d;
+    }
+    size_t getRowStride() const {  // Number of elements between rows
+        return m_stride;
+    }
+
+    // The top-left pixel. Rows are `getRowStride()` elements apart.
+    T* data() const {
+        return m_data;
+    }
+    T& at(size_t x, size_t y, size_t z) const {
+        return m_data[y * m_stride + x * m_d + z];
+    }
+
+    // Sub-rectangle from (x, y) of this view
+    CpuImageView view(size_t x, size_t y, size_t w, size_t h) const {
+        if (m_w < x || m_w - x < w || m_h < y || m_h - y < h) {
+            throw std::runtime_error("Out of range to view");
+        }
+        return {m_owner, m_data + y * m_stride + x * m_d, w, h, m_d, m_stride};
+    }
+
+    // Upload to a new texture of the view size
+    GpuImagePtr<ValueType> toGpu() const;
+
+    // Same as `CpuImage::foreach`, where (x, y) is relative to the view
+    template <typename F>
+    void foreach (F func, size_t n_worker = 0, ForeachTile tile = {}) const {
+        CpuImage<ValueType>::ForeachTiles(m_data, m_w, m_h, m_d, m_stride, func,
+                                          n_worker, tile);
+    }
+
+private:
+    template <typename U>
+    friend class CpuImageView;
+
+    std::shared_ptr<const void> m_owner;
+    T* m_data = nullptr;
+    size_t m_w = 0, m_h = 0, m_d = 0;
+    size_t m_stride = 0;
+};
+
+// ================================ GPU Readback ===============================
+// Pixels being copied from a `GpuImage` by `toCpuAsync()` into a pixel pack
+// buffer, so that the GPU is not stalled until they are needed. Copies share
+// the result. Must be used in the GL context of the image, which may be
+// released before.
+template <typename T>
+class GpuReadback {
+public:
+    GpuReadback();  // Empty, whose result is nullptr
+
+    // Whether the pixels arrived (never waits)
+    bool ready() const;
+    // Wait for the pixels if needed (the same image for later calls)
+    CpuImagePtr<T> get();
+
+private:
+    friend class GpuImage<T>;
+    class Impl;
+    explicit GpuReadback(const std::shared_ptr<Impl>& impl);
+    std::shared_ptr<Impl> m_impl;
+};
+
 // ================================= GPU Image =================================
 template <typename T>
 class GpuImage : public GpuImageBase {
@@ -130,6 +668,8 @@ public:
 
     GpuImage();
     GpuImage(size_t w, size_t h, size_t d);
+    // With `n_level` mip levels (0: full chain)
+    GpuImage(size_t w, size_t h, size_t d, size_t n_level);
 
     GpuImage(const GpuImage&);
     GpuImage(GpuImage&&);
@@ -137,16 +677,44 @@ public:
     GpuImage& operator=(GpuImage&&);
     virtual ~GpuImage();
 
-    CpuImagePtr<T> toCpu() const;
+    CpuImagePtr<T> toCpu(size_t level = 0) const;
+    // Start copying asynchronously. Pack buffers are reused in a ring, where
+    // a readback not resolved by the next round is waited for then.
+    GpuReadback<T> toCpuAsync(size_t level = 0) const;
+    // Upload to level 0, whose other levels are updated by `generateMipmaps()`.
+    // Reallocated to the image size if different, with mipmaps if it had.
+    // Mutable CPU images upload only their dirty regions if the texture was
+    // last written by uploading the same image, and their tracking state is
+    // updated. Const ones are always uploaded entirely. (Rendering and
+    // `GpuUploadRing` are not tracked)
     void fromCpu(const CpuImagePtr<T>& cpu_img);
+    void fromCpu(CpuImage<T>& cpu_img);
     void fromCpu(const CpuImage<T>& cpu_img);
+    void fromCpu(const CpuImageView<const T>& cpu_view);
+    // Update the rectangle from (x, y) with the view, which must be inside
+    void fromCpu(const CpuImageView<const T>& cpu_view, size_t x, size_t y);
+    // Allocate `levels.size()` levels and upload all of them. Level `i` must
+    // be `GetMipSize()` of level 0. (e.g. from `BuildMipmaps()`)
+    void fromCpu(const std::vector<CpuImagePtr<T>>& levels);
+
+    // Fill levels 1 and later from level 0 by the driver
+    void generateMipmaps();
 
     virtual void init(size_t w, size_t h, size_t d) override;
+    void init(size_t w, size_t h, size_t d, size_t n_level);
     virtual bool empty() const override;
     virtual size_t getWidth() const override;
     virtual size_t getHeight() const override;
     virtual size_t getDepth() const override;
 
+    size_t getLevelCount() const;
+
+    // Sampling, kept until reallocation. Defaults are NEAREST without
+    // mipmaps, and LINEAR_MIPMAP_LINEAR (min) and LINEAR (mag) with them.
+    void setFilter(TextureFilter min_filter, TextureFilter mag_filter);
+    // Levels for sampling, clamped into allocated ones
+    void setLevelRange(size_t base_level, size_t max_level);
+
     virtual int getTextureId() const override;
 
 private:
@@ -154,13 +722,204 @@ private:
     std::unique_ptr<Impl> m_impl;
 };
 
+// ============================== GPU Upload Ring ==============================
+// Staging memory for texture uploads: `n_slot` slots of `slot_bytes` in a
+// persistently mapped unpack buffer, from which the driver copies without
+// blocking the caller. `acquire()` and `commit()` must be called in the GL
+// context, and the slot in between may be filled in any threads. (e.g. by
+// `ParallelFor()`, which finishes them before returning) Slots are reused
+// in turn, each after the GPU has read it. Requires OpenGL 4.4.
+template <typename T>
+class GpuUploadRing {
+public:
+    template <typename... Args>
+    static auto Create(Args... args) {
+        return std::make_shared<GpuUploadRing>(args...);
+    }
+
+    GpuUploadRing(size_t slot_bytes, size_t n_slot = 3);
+    GpuUploadRing(const GpuUploadRing&) = delete;
+    GpuUploadRing& operator=(const GpuUploadRing&) = delete;
+    ~GpuUploadRing();
+
+    // Next slot as a dense image, waiting for the GPU if it is still read.
+    // The view is valid until committed.
+    CpuImageView<T> acquire(size_t w, size_t h, size_t d);
+    // Copy an acquired slot (or its sub-view) to the rectangle from (x, y) of
+    // `level`, which must be inside, and hand the slot back to the ring.
+    void commit(const CpuImageView<const T>& slot, GpuImage<T>& gpu_img,
+                size_t x = 0, size_t y = 0, size_t level = 0);
+    // `acquire()`, copy rows of `cpu_view` in parallel and `commit()`
+    void upload(const CpuImageView<const T>& cpu_view, GpuImage<T>& gpu_img,
+                size_t x = 0, size_t y = 0, size_t level = 0);
+    // Same, but converting rows of another type into the slot in parallel as
+    // `CpuImage::convertTo()`. (e.g. 8-bit frames into a float texture)
+    template <typename U>
+    void upload(const CpuImageView<const U>& cpu_view, GpuImage<T>& gpu_img,
+                size_t x = 0, size_t y = 0, size_t level = 0,
+                float scale = 1.f, float bias = 0.f);
+
+    size_t getSlotBytes() const;
+    size_t getSlotCount() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// ============================== GPU Image Array ==============================
+// `n_layer` images of the same size in one `GL_TEXTURE_2D_ARRAY`, which is
+// bound once and indexed by `sampler2DArray` in shaders. Mip levels keep all
+// the layers. Layers are uploaded and read back one by one.
+template <typename T>
+class GpuImageArray {
+public:
+    using ValueType = T;
+
+    template <typename... Args>
+    static auto Create(Args... args) {
+        return std::make_shared<GpuImageArray>(args...);
+    }
+
+    GpuImageArray();
+    // With `n_level` mip levels (0: full chain)
+    GpuImageArray(size_t w, size_t h, size_t d, size_t n_layer,
+                  size_t n_level = 1);
+
+    GpuImageArray(const GpuImageArray&);
+    GpuImageArray(GpuImageArray&&);
+    GpuImageArray& operator=(const GpuImageArray&);
+    GpuImageArray& operator=(GpuImageArray&&);
+    ~GpuImageArray();
+
+    CpuImagePtr<T> toCpu(size_t layer, size_t level = 0) const;
+    // Upload to `layer` of level 0, which must be the image size
+    void fromCpu(size_t layer, const CpuImagePtr<T>& cpu_img);
+    void fromCpu(size_t layer, const CpuImage<T>& cpu_img);
+    // Update the rectangle from (x, y) of `layer`, which must be inside
+    void fromCpu(size_t layer, const CpuImageView<const T>& cpu_view,
+                 size_t x = 0, size_t y = 0);
+    // Reallocated to the images (same size) as layers if different, with
+    // mipmaps if it had, and upload all of them
+    void fromCpu(const std::vector<CpuImagePtr<T>>& layers);
+
+    // Fill levels 1 and later from level 0 by the driver
+    void generateMipmaps();
+
+    void init(size_t w, size_t h, size_t d, size_t n_layer,
+              size_t n_level = 1);
+    bool empty() const;
+    size_t getWidth() const;
+    size_t getHeight() const;
+    size_t getDepth() const;
+    size_t getLayerCount() const;
+    size_t getLevelCount() const;
+
+    // Same as `GpuImage`
+    void setFilter(TextureFilter min_filter, TextureFilter mag_filter);
+    void setLevelRange(size_t base_level, size_t max_level);
+
+    int getTextureId() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// ================================ GPU Image 3D ===============================
+// Volume of `n_slice` images in one `GL_TEXTURE_3D`, sampled by `sampler3D`
+// with filtering across slices. Unlike arrays, mip levels also halve slices
+// (`GetMipSize(n_slice, level)` in each). Slices are uploaded and read back
+// one by one.
+template <typename T>
+class GpuImage3D {
+public:
+    using ValueType = T;
+
+    template <typename... Args>
+    static auto Create(Args... args) {
+        return std::make_shared<GpuImage3D>(args...);
+    }
+
+    GpuImage3D();
+    // With `n_level` mip levels (0: full chain down to 1x1x1)
+    GpuImage3D(size_t w, size_t h, size_t d, size_t n_slice,
+               size_t n_level = 1);
+
+    GpuImage3D(const GpuImage3D&);
+    GpuImage3D(GpuImage3D&&);
+    GpuImage3D& operator=(const GpuImage3D&);
+    GpuImage3D& operator=(GpuImage3D&&);
+    ~GpuImage3D();
+
+    CpuImagePtr<T> toCpu(size_t slice, size_t level = 0) const;
+    // Upload to `slice` of level 0, which must be the image size
+    void fromCpu(size_t slice, const CpuImagePtr<T>& cpu_img);
+    void fromCpu(size_t slice, const CpuImage<T>& cpu_img);
+    // Update the rectangle from (x, y) of `slice`, which must be inside
+    void fromCpu(size_t slice, const CpuImageView<const T>& cpu_view,
+                 size_t x = 0, size_t y = 0);
+    // Reallocated to the images (same size) as slices if different, with
+    // mipmaps if it had, and upload all of them
+    void fromCpu(const std::vector<CpuImagePtr<T>>& slices);
+
+    // Fill levels 1 and later from level 0 by the driver
+    void generateMipmaps();
+
+    void init(size_t w, size_t h, size_t d, size_t n_slice,
+              size_t n_level = 1);
+    bool empty() const;
+    size_t getWidth() const;
+    size_t getHeight() const;
+    size_t getDepth() const;
+    size_t getSliceCount() const;
+    size_t getLevelCount() const;
+
+    // Same as `GpuImage`
+    void setFilter(TextureFilter min_filter, TextureFilter mag_filter);
+    void setLevelRange(size_t base_level, size_t max_level);
+
+    int getTextureId() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// ------------------------ CPU Image View (templates) -------------------------
+template <typename T>
+GpuImagePtr<typename CpuImageView<T>::ValueType> CpuImageView<T>::toGpu()
+        const {
+    auto gpu_img = GpuImage<ValueType>::Create();
+    gpu_img->fromCpu(*this);
+    return gpu_img;
+}
+
 // ------------------------------ Specialization -------------------------------
 template class CpuImage<uint8_t>;
+template class CpuImage<uint16_t>;
 template class CpuImage<float>;
 template class CpuImage<Float16>;
 template class GpuImage<uint8_t>;
+template class GpuImage<uint16_t>;
 template class GpuImage<float>;
 template class GpuImage<Float16>;
+template class GpuReadback<uint8_t>;
+template class GpuReadback<uint16_t>;
+template class GpuReadback<float>;
+template class GpuReadback<Float16>;
+template class GpuUploadRing<uint8_t>;
+template class GpuUploadRing<uint16_t>;
+template class GpuUploadRing<float>;
+template class GpuUploadRing<Float16>;
+template class GpuImageArray<uint8_t>;
+template class GpuImageArray<uint16_t>;
+template class GpuImageArray<float>;
+template class GpuImageArray<Float16>;
+template class GpuImage3D<uint8_t>;
+template class GpuImage3D<uint16_t>;
+template class GpuImage3D<float>;
+template class GpuImage3D<Float16>;
 
 }  // namespace oglw
 
@@ -0,0 +1,63 @@
+#ifndef OGLW_IMAGE_FILTER_H_190520
+#define OGLW_IMAGE_FILTER_H_190520
+
+#include <vector>
+
+#include <oglw/image.h>
+
+namespace oglw {
+
+// ================================ Border Mode ================================
+// Pixels read by filters outside of the image `abcd`
+enum class BorderMode {
+    CLAMP,    // aaa|abcd|ddd
+    REFLECT,  // dcb|abcd|cba (the edge is not repeated)
+    WRAP,     // bcd|abcd|abc
+    ZERO,     // 000|abcd|000
+};
+
+// =============================== Image Filter ================================
+// Filters return a new dense image of the same layout. Each channel is
+// filtered in float, and the result is rounded and clamped as `convertTo()`.
+// Bands of rows are filtered in parallel, each of which is passed
+// horizontally into a small float buffer and then vertically.
+// Kernels are applied without flip (correlation), and their sizes are odd.
+// `T` is one of uint8_t, uint16_t, float and Float16.
+
+// Separable filter of `kernel_x` (horizontal) and `kernel_y` (vertical)
+template <typename T>
+CpuImagePtr<T> FilterSeparable(const CpuImage<T>& src,
+                               const std::vector<float>& kernel_x,
+                               const std::vector<float>& kernel_y,
+                               BorderMode border = BorderMode::REFLECT);
+
+// Convolution of `kernel_w * kernel_h` values in row-major order
+template <typename T>
+CpuImagePtr<T> Convolve(const CpuImage<T>& src,
+                        const std::vector<float>& kernel, size_t kernel_w,
+                        size_t kernel_h,
+                        BorderMode border = BorderMode::REFLECT);
+
+// Gaussian blur whose radius is `ceil(3 * sigma)`
+template <typename T>
+CpuImagePtr<T> GaussianBlur(const CpuImage<T>& src, float sigma,
+                            BorderMode border = BorderMode::REFLECT);
+
+// Mean of `(2 * radius + 1)^2` pixels
+template <typename T>
+CpuImagePtr<T> BoxBlur(const CpuImage<T>& src, size_t radius,
+                       BorderMode border = BorderMode::REFLECT);
+
+// 3x3 Sobel derivative along x (`dx == 1`) or y (`dy == 1`). Values are not
+// normalized, so that their signs are kept in float.
+template <typename T>
+CpuImagePtr<float> Sobel(const CpuImage<T>& src, size_t dx, size_t dy,
+                         BorderMode border = BorderMode::REFLECT);
+
+// Normalized 1D Gaussian of `2 * radius + 1` values
+// (`radius == 0`: `ceil(3 * sigma)`)
+std::vector<float> GetGaussianKernel(float sigma, size_t radius = 0);
+
+}  // namespace oglw
+
+#endif /* end of include guard */
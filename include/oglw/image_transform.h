@@ -0,0 +1,57 @@
+#ifndef OGLW_IMAGE_TRANSFORM_H_190522
+#define OGLW_IMAGE_TRANSFORM_H_190522
+
+#include <oglw/image.h>
+
+#include <vector>
+
+namespace oglw {
+
+// =============================== Resize Filter ===============================
+enum class ResizeFilter {
+    BILINEAR,  // Triangle of radius 1
+    BICUBIC,   // Catmull-Rom (a = -0.5) of radius 2
+    LANCZOS3,  // Windowed sinc of radius 3
+    BOX,       // Average of covered pixels (radius 0.5)
+    KAISER,    // Kaiser-windowed (alpha = 4) sinc of radius 3
+};
+
+// ============================== Image Transform ==============================
+// Transforms return a new dense image of the same layout, except for the
+// in-place flip. `T` is one of uint8_t, uint16_t, float and Float16.
+
+// Resample to `w` x `h` with weights precomputed for each row and column.
+// Filters are widened for downscaling, so that they also work as low-pass.
+// Pixels are taken as areas, whose centers are at `(x + 0.5) * scale`, and
+// borders are clamped. Integer results are rounded and clamped as
+// `convertTo()`.
+template <typename T>
+CpuImagePtr<T> Resize(const CpuImage<T>& src, size_t w, size_t h,
+                      ResizeFilter filter = ResizeFilter::BILINEAR);
+
+// `dst.at(y, x) == src.at(x, y)`, copied by cache-sized blocks
+template <typename T>
+CpuImagePtr<T> Transpose(const CpuImage<T>& src);
+
+// Rotate by `n_turn * 90` degrees counterclockwise, with y axis upward as
+// OpenGL (negative: clockwise). One turn is `dst.at(h - 1 - y, x) ==
+// src.at(x, y)`.
+template <typename T>
+CpuImagePtr<T> Rotate90(const CpuImage<T>& src, int n_turn);
+
+// Swap rows upside down in place
+template <typename T>
+void FlipVertical(CpuImage<T>& img);
+
+// ================================== Mipmap ===================================
+// Mip levels from `src` (level 0, shared by copy-on-write) to `n_level` levels
+// (0: full chain down to 1x1), each resized from the previous one to
+// `GetMipSize()`. Halving by BOX averages 2x2 pixels in parallel rows.
+template <typename T>
+std::vector<CpuImagePtr<T>> BuildMipmaps(
+        const CpuImage<T>& src, ResizeFilter filter = ResizeFilter::BOX,
+        size_t n_level = 0);
+
+}  // namespace oglw
+
+#endif /* end of include guard */
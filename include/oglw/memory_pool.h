@@ -0,0 +1,46 @@
+#ifndef OGLW_MEMORY_POOL_H_190502
+#define OGLW_MEMORY_POOL_H_190502
+
+#include <cstddef>
+
+namespace oglw {
+
+// ================================ Memory Pool ================================
+// Library-wide pool which recycles large buffers (e.g. pixel arrays) by size
+// class. Buffers smaller than `MEMORY_POOL_MIN_BYTES` bypass the pool.
+// Buffers not smaller than the map threshold are mapped from the OS directly
+// (anonymous memory with huge page hints). Their pages are zero-filled lazily
+// on the first touch and are returned to the OS on free.
+// All functions are thread-safe.
+static constexpr size_t MEMORY_POOL_MIN_BYTES = 64 * 1024;
+
+struct MemoryPoolStats {
+    size_t n_hit = 0;         // Allocations served from the cache
+    size_t n_miss = 0;        // Allocations which fell through to the heap
+    size_t n_cached = 0;      // Number of currently cached buffers
+    size_t cached_bytes = 0;  // Total bytes of currently cached buffers
+    size_t n_mapped = 0;      // Number of currently mapped buffers
+    size_t mapped_bytes = 0;  // Total bytes of currently mapped buffers
+};
+
+// Allocate/free raw bytes. `n_bytes` must be the same for both.
+unsigned char* PoolAllocate(size_t n_bytes);
+void PoolFree(unsigned char* ptr, size_t n_bytes);
+
+// Upper bound of cached bytes. Exceeded buffers are returned to the heap.
+void SetMemoryPoolCapacity(size_t max_bytes);
+size_t GetMemoryPoolCapacity();
+
+// Buffers of `n_bytes` or larger are mapped. (SIZE_MAX disables mapping)
+void SetMemoryPoolMapThreshold(size_t n_bytes);
+size_t GetMemoryPoolMapThreshold();
+
+// Return cached buffers to the heap until `max_bytes` remain.
+void TrimMemoryPool(size_t max_bytes = 0);
+
+MemoryPoolStats GetMemoryPoolStats();
+void ResetMemoryPoolStats();
+
+}  // namespace oglw
+
+#endif /* end of include guard */
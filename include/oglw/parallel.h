@@ -0,0 +1,43 @@
+#ifndef OGLW_PARALLEL_H_190503
+#define OGLW_PARALLEL_H_190503
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace oglw {
+
+// ================================= Parallel ==================================
+// Call `func(begin, end)` over sub ranges of [0, n) on the library-wide
+// work-stealing thread pool, which is started lazily. The calling thread also
+// works until all ranges are finished. Exceptions are rethrown in the calling
+// thread. `n_worker` is the number of ranges.
+// (0: automatic, 1: only in the calling thread)
+void ParallelFor(size_t n,
+                 const std::function<void(size_t begin, size_t end)>& func,
+                 size_t n_worker = 0);
+
+// Same as `ParallelFor()`, but [0, n) is split into `GetParallelWorkerCount()`
+// ranges whose i-th one is always run by the i-th worker, without the calling
+// thread. With workers bound to CPUs, pages first touched in a range stay on
+// the NUMA node of the worker which visits the same range later. Same as
+// `ParallelFor()` if not bound by `SetParallelWorkers()` or called in workers.
+void ParallelForPinned(
+        size_t n, const std::function<void(size_t begin, size_t end)>& func);
+
+// Arrays and images of at least this size are first touched and visited by
+// `ParallelForPinned()`
+constexpr size_t PARALLEL_PINNED_BYTES = 16 * 1024 * 1024;
+
+// Restart the thread pool with `n_worker` workers (0: hardware concurrency - 1)
+// whose i-th one is bound to `cpus[i % cpus.size()]` (empty: not bound).
+// Must not be called while ParallelFor() is running.
+void SetParallelWorkers(size_t n_worker,
+                        const std::vector<size_t>& cpus = {});
+size_t GetParallelWorkerCount();
+// Whether workers are bound to CPUs
+bool HasParallelAffinity();
+
+}  // namespace oglw
+
+#endif /* end of include guard */
@@ -24,127 +24,334 @@
 #endif
 
 #include "fast_array.h"
+#include "image_convert.h"
+#include "mapped_file.h"
 
+#include <algorithm>
 #include <atomic>
-#include <thread>
-#include <vector>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Impls are defined only in this file, and may hold its local helpers
+#if defined __GNUC__ && !defined __clang__
+#pragma GCC diagnostic ignored "-Wsubobject-linkage"
+#endif
 
 namespace oglw {
 
 namespace {
 
 // -----------------------------------------------------------------------------
+// Head of pixel arrays is aligned to cache line
+constexpr size_t PIXEL_ALIGN = 64;
+
 template <typename T>
-T CastFromUint8(uint8_t v);
+using PixelArray = FastArray<T, PIXEL_ALIGN>;
 
-template <>
-uint8_t CastFromUint8(uint8_t v) {
-    return v;
+size_t Gcd(size_t a, size_t b) {
+    while (b != 0) {
+        const size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+size_t ComputeRowStride(size_t w, size_t d, size_t elem_size,
+                        size_t row_align) {
+    // Dense rows
+    if (row_align == 0) {
+        return w * d;
+    }
+    if ((row_align & (row_align - 1)) != 0 || PIXEL_ALIGN < row_align) {
+        throw std::runtime_error("Invalid row alignment: " +
+                                 std::to_string(row_align));
+    }
+    // Round up the width, so that a row consists of whole pixels and its size
+    // is a multiple of `row_align` bytes.
+    const size_t px_step = row_align / Gcd(row_align, d * elem_size);
+    return (w + px_step - 1) / px_step * px_step * d;
+}
+
+// -----------------------------------------------------------------------------
+// Interleaved row of `w` pixels -> `d` planar rows of `plane_stride` apart
+template <size_t D, typename T>
+void DeinterleaveRow(const T* src, T* dst, size_t w, size_t d,
+                     size_t plane_stride) {
+    const size_t n_ch = (D == 0) ? d : D;
+    for (size_t x = 0; x < w; x++) {
+        for (size_t z = 0; z < n_ch; z++) {
+            dst[z * plane_stride + x] = src[x * n_ch + z];
+        }
+    }
+}
+
+// `d` planar rows of `plane_stride` apart -> interleaved row of `w` pixels
+template <size_t D, typename T>
+void InterleaveRow(const T* src, T* dst, size_t w, size_t d,
+                   size_t plane_stride) {
+    const size_t n_ch = (D == 0) ? d : D;
+    for (size_t x = 0; x < w; x++) {
+        for (size_t z = 0; z < n_ch; z++) {
+            dst[x * n_ch + z] = src[z * plane_stride + x];
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Maximum value of normalized range ([0, 1] for floating point)
+template <typename T>
+float GetValueRange() {
+    return 1.f;
 }
 
 template <>
-float CastFromUint8(uint8_t v) {
-    return static_cast<float>(v) / 255.f;
+float GetValueRange<uint8_t>() {
+    return 255.f;
 }
 
 template <>
-Float16 CastFromUint8(uint8_t v) {
-    return CastFromUint8<float>(v);
+float GetValueRange<uint16_t>() {
+    return 65535.f;
+}
+
+template <typename T>
+constexpr bool IsFloatingValue() {
+    return std::is_same<T, float>::value || std::is_same<T, Float16>::value;
+}
+
+// -----------------------------------------------------------------------------
+// Side of square tiles (pixels) whose writes are tracked for uploads
+constexpr size_t DIRTY_TILE_SIZE = 64;
+
+uint64_t NewSyncId() {
+    static std::atomic<uint64_t> s_sync_id{0};
+    return ++s_sync_id;
+}
+
+// -----------------------------------------------------------------------------
+// Images smaller than this are converted in the calling thread
+constexpr size_t CONVERT_INLINE_SIZE = 256 * 1024;
+// Number of values converted in a task
+constexpr size_t CONVERT_CHUNK_SIZE = 64 * 1024;
+
+// -----------------------------------------------------------------------------
+ImageFormat GetImageFormat(const std::string& filename) {
+    const size_t dot = filename.rfind('.');
+    if (dot == std::string::npos) {
+        return ImageFormat::JPEG;
+    }
+    std::string ext = filename.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    if (ext == "png") {
+        return ImageFormat::PNG;
+    } else if (ext == "bmp") {
+        return ImageFormat::BMP;
+    } else if (ext == "tga") {
+        return ImageFormat::TGA;
+    } else if (ext == "pfm") {
+        return ImageFormat::PFM;
+    } else if (ext == "raw") {
+        return ImageFormat::RAW;
+    } else if (ext == "oglw") {
+        return ImageFormat::NATIVE;
+    }
+    return ImageFormat::JPEG;  // Default
+}
+
+bool IsLittleEndian() {
+    const uint16_t v = 1;
+    uint8_t head;
+    std::memcpy(&head, &v, 1);
+    return head == 1;
 }
 
 // -----------------------------------------------------------------------------
+// Native container: this header followed by the pixels as in memory (with row
+// padding, from the bottom row) at `payload_offset`, in host byte order.
+constexpr char NATIVE_MAGIC[8] = "OGLWIMG";
+constexpr uint32_t NATIVE_VERSION = 1;
+
+struct NativeImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t type;  // NativeType
+    uint64_t width, height, depth;
+    uint64_t row_stride;  // Number of elements between rows
+    uint64_t payload_offset;
+    uint64_t reserved;
+};
+static_assert(sizeof(NativeImageHeader) == 64, "Unexpected padding");
+static_assert(sizeof(NativeImageHeader) % PIXEL_ALIGN == 0,
+              "Payload must be aligned");
+
+enum NativeType : uint32_t {
+    NATIVE_UINT8 = 1,
+    NATIVE_UINT16 = 2,
+    NATIVE_FLOAT32 = 3,
+    NATIVE_FLOAT16 = 4,
+};
+
 template <typename T>
-uint8_t CastToUint8(T v);
+uint32_t GetNativeType();
 
 template <>
-uint8_t CastToUint8(uint8_t v) {
-    return v;
+uint32_t GetNativeType<uint8_t>() {
+    return NATIVE_UINT8;
 }
 
 template <>
-uint8_t CastToUint8(float v) {
-    return static_cast<uint8_t>(std::min(std::max(v * 255.f, 0.f), 255.f));
+uint32_t GetNativeType<uint16_t>() {
+    return NATIVE_UINT16;
 }
 
 template <>
-uint8_t CastToUint8(Float16 v) {
-    return CastFromUint8<float>(v.v);
+uint32_t GetNativeType<float>() {
+    return NATIVE_FLOAT32;
 }
 
-// -----------------------------------------------------------------------------
-template <typename T>
-void ForeachThread(FastArray<T>& array, size_t w, size_t h, size_t d,
-                   std::function<void(size_t x, size_t y, size_t z, T& v)> func,
-                   size_t n_worker) {
-    std::atomic<size_t> next_y(0);
-    std::vector<std::thread> workers(n_worker);
-    for (auto&& worker : workers) {
-        worker = std::thread([&]() {
-            size_t y = 0;
-            while ((y = next_y++) < h) {
-                auto itr = array.begin();
-                std::advance(itr, y * w * d);
-                for (size_t x = 0; x < w; x++) {
-                    for (size_t z = 0; z < d; z++) {
-                        func(x, y, z, *itr++);
-                    }
-                }
-            }
-        });
+template <>
+uint32_t GetNativeType<Float16>() {
+    return NATIVE_FLOAT16;
+}
+
+size_t GetNativeTypeSize(uint32_t type) {
+    switch (type) {
+        case NATIVE_UINT8: return 1;
+        case NATIVE_UINT16: return 2;
+        case NATIVE_FLOAT32: return 4;
+        case NATIVE_FLOAT16: return 2;
+    }
+    return 0;
+}
+
+NativeImageHeader ReadNativeHeader(const MappedFile& file,
+                                   const std::string& filename) {
+    NativeImageHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("Invalid native image (size): " + filename);
     }
-    for (auto&& worker : workers) {
-        worker.join();
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, NATIVE_MAGIC, sizeof(NATIVE_MAGIC)) != 0 ||
+        header.version != NATIVE_VERSION) {
+        throw std::runtime_error("Invalid native image (header): " + filename);
     }
+    // Sizes are compared by division, so that crafted ones do not overflow.
+    // Rows must be whole pixels for `GL_UNPACK_ROW_LENGTH`.
+    const size_t elem_size = GetNativeTypeSize(header.type);
+    if (elem_size == 0 || header.depth == 0 || 4 < header.depth ||
+        header.payload_offset % PIXEL_ALIGN != 0 ||
+        header.row_stride % header.depth != 0 ||
+        header.row_stride / header.depth < header.width) {
+        throw std::runtime_error("Invalid native image (format): " + filename);
+    }
+    const uint64_t file_size = file.size();
+    if (file_size < header.payload_offset ||
+        (header.row_stride != 0 &&
+         (file_size - header.payload_offset) / elem_size / header.row_stride <
+                 header.height)) {
+        throw std::runtime_error("Invalid native image (payload): " +
+                                 filename);
+    }
+    return header;
 }
 
-template <typename T>
-void ForeachThread(FastArray<T>& array, size_t w, size_t h, size_t d,
-                   std::function<void(size_t x, size_t y, T* channel_vs)> func,
-                   size_t n_worker) {
-    std::atomic<size_t> next_y(0);
-    std::vector<std::thread> workers(n_worker);
-    for (auto&& worker : workers) {
-        worker = std::thread([&]() {
-            size_t y = 0;
-            while ((y = next_y++) < h) {
-                auto itr = array.begin();
-                std::advance(itr, y * w * d);
-                for (size_t x = 0; x < w; x++, itr += d) {
-                    func(x, y, itr);
-                }
-            }
-        });
+// -----------------------------------------------------------------------------
+using FilePtr = std::unique_ptr<FILE, int (*)(FILE*)>;
+
+FilePtr OpenFile(const std::string& filename, const char* mode) {
+    FilePtr file(std::fopen(filename.c_str(), mode), std::fclose);
+    if (!file) {
+        throw std::runtime_error("Failed to open: " + filename);
     }
-    for (auto&& worker : workers) {
-        worker.join();
+    return file;
+}
+
+void WriteFile(const FilePtr& file, const void* data, size_t n_bytes,
+               const std::string& filename) {
+    if (std::fwrite(data, 1, n_bytes, file.get()) != n_bytes) {
+        throw std::runtime_error("Failed to save: " + filename);
     }
 }
 
-template <typename T>
-void ForeachSimple(
-        FastArray<T>& array, size_t w, size_t h, size_t d,
-        std::function<void(size_t x, size_t y, size_t z, T& v)> func) {
-    auto itr = array.begin();
-    for (size_t y = 0; y < h; y++) {
-        for (size_t x = 0; x < w; x++) {
-            for (size_t z = 0; z < d; z++) {
-                func(x, y, z, *itr++);
+// -----------------------------------------------------------------------------
+// Flags of written tiles, which are atomic so that mutable accesses of an
+// unshared image may run in parallel. (e.g. `at()` in `ParallelFor()`)
+class DirtyTiles {
+public:
+    DirtyTiles() = default;
+    DirtyTiles(const DirtyTiles& lhs) {
+        *this = lhs;
+    }
+
+    DirtyTiles& operator=(const DirtyTiles& lhs) {
+        if (this != &lhs) {
+            resize(lhs.m_n_x, lhs.m_n_y);
+            for (size_t i = 0; i < m_n_x * m_n_y; i++) {
+                m_flags[i].store(lhs.m_flags[i].load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
             }
+            m_all.store(lhs.isAll(), std::memory_order_relaxed);
         }
+        return *this;
     }
-}
 
-template <typename T>
-void ForeachSimple(
-        FastArray<T>& array, size_t w, size_t h, size_t d,
-        std::function<void(size_t x, size_t y, T* channel_vs)> func) {
-    auto itr = array.begin();
-    for (size_t y = 0; y < h; y++) {
-        for (size_t x = 0; x < w; x++, itr += d) {
-            func(x, y, itr);
+    void markAll() {
+        m_all.store(true, std::memory_order_relaxed);
+    }
+
+    bool isAll() const {
+        return m_all.load(std::memory_order_relaxed);
+    }
+
+    void mark(size_t tx, size_t ty) {
+        // Store only once, not to bounce the cache line between threads
+        std::atomic<uint8_t>& flag = m_flags[ty * m_n_x + tx];
+        if (!flag.load(std::memory_order_relaxed)) {
+            flag.store(1, std::memory_order_relaxed);
         }
     }
-}
+
+    bool isMarked(size_t tx, size_t ty) const {
+        return m_flags[ty * m_n_x + tx].load(std::memory_order_relaxed) != 0;
+    }
+
+    // No tile is marked, in a grid of `n_x` x `n_y` tiles
+    void clear(size_t n_x, size_t n_y) {
+        resize(n_x, n_y);
+        for (size_t i = 0; i < m_n_x * m_n_y; i++) {
+            m_flags[i].store(0, std::memory_order_relaxed);
+        }
+        m_all.store(false, std::memory_order_relaxed);
+    }
+
+    size_t getCountX() const {
+        return m_n_x;
+    }
+
+    size_t getCountY() const {
+        return m_n_y;
+    }
+
+private:
+    void resize(size_t n_x, size_t n_y) {
+        if (n_x * n_y != m_n_x * m_n_y) {
+            m_flags.reset(new std::atomic<uint8_t>[n_x * n_y]);
+        }
+        m_n_x = n_x;
+        m_n_y = n_y;
+    }
+
+    std::atomic<bool> m_all{true};
+    std::unique_ptr<std::atomic<uint8_t>[]> m_flags;
+    size_t m_n_x = 0, m_n_y = 0;
+};
 
 // -----------------------------------------------------------------------------
 
@@ -156,26 +363,64 @@ template <typename T>
 class CpuImage<T>::Impl {
 public:
     Impl() {}
-    Impl(size_t w, size_t h, size_t d) {
-        init(w, h, d);
+    Impl(size_t w, size_t h, size_t d, size_t row_align = 0,
+         ImageLayout layout = ImageLayout::INTERLEAVED) {
+        init(w, h, d, row_align, layout);
+    }
+
+    Impl(const Impl& lhs) {
+        *this = lhs;
     }
 
-    Impl(const Impl&) = default;
     Impl(Impl&&) = delete;
-    Impl& operator=(const Impl&) = default;
+
+    Impl& operator=(const Impl& lhs) {
+        if (this == &lhs) {
+            return *this;
+        }
+        m_w = lhs.m_w;
+        m_h = lhs.m_h;
+        m_d = lhs.m_d;
+        m_stride = lhs.m_stride;
+        m_row_align = lhs.m_row_align;
+        m_layout = lhs.m_layout;
+        if (lhs.m_pixels->unshareable) {
+            // Mutable views may write them at any time
+            m_pixels = std::make_shared<SharedPixels>();
+            m_pixels->array =
+                    std::make_shared<PixelArray<T>>(*lhs.m_pixels->array);
+        } else {
+            m_pixels = lhs.m_pixels;
+        }
+        m_dirty = lhs.m_dirty;
+        m_sync_id = lhs.m_sync_id;
+        return *this;
+    }
+
     Impl& operator=(Impl&&) = delete;
     ~Impl() = default;
 
     // -------------------------------------------------------------------------
-    void init(size_t w, size_t h, size_t d) {
+    void init(size_t w, size_t h, size_t d, size_t row_align = 0,
+              ImageLayout layout = ImageLayout::INTERLEAVED) {
+        const bool planar = (layout == ImageLayout::PLANAR);
+        m_stride = ComputeRowStride(w, planar ? 1 : d, sizeof(T), row_align);
         m_w = w;
         m_h = h;
         m_d = d;
-        m_array.alloc(w * h * d);
+        m_row_align = row_align;
+        m_layout = layout;
+        if (m_pixels.use_count() != 1 || m_pixels->array.use_count() != 1) {
+            // Do not touch the pixels shared with copies or views
+            m_pixels = std::make_shared<SharedPixels>();
+        }
+        m_pixels->unshareable = false;  // No view is left
+        m_pixels->array->alloc(m_stride * h * (planar ? d : 1));
+        markDirty();
     }
 
     bool empty() const {
-        return m_array.empty();
+        return m_pixels->array->empty();
     }
 
     size_t getWidth() const {
@@ -190,89 +435,512 @@ public:
         return m_d;
     }
 
+    size_t getRowStride() const {
+        return m_stride;
+    }
+
+    ImageLayout getLayout() const {
+        return m_layout;
+    }
+
+    void setLayout(ImageLayout layout) {
+        if (layout == m_layout) {
+            return;
+        }
+        if (m_d <= 1) {
+            // Same in memory
+            m_layout = layout;
+            return;
+        }
+        // Rearrange into new pixels (the current ones are left to the others)
+        const auto src_pixels = m_pixels;
+        const size_t src_stride = m_stride;
+        m_pixels = std::make_shared<SharedPixels>();
+        init(m_w, m_h, m_d, m_row_align, layout);
+
+        const T* src = src_pixels->array->data();
+        T* dst = m_pixels->array->data();
+        const bool to_planar = (layout == ImageLayout::PLANAR);
+        const size_t planar_stride = to_planar ? m_stride : src_stride;
+        const size_t plane_stride = planar_stride * m_h;
+        const size_t w = m_w, d = m_d;
+        const size_t n_worker = (w * m_h * d < CONVERT_INLINE_SIZE) ? 1 : 0;
+        DispatchDepth(d, [&](auto depth) {
+            constexpr size_t D = decltype(depth)::value;
+            ParallelFor(m_h,
+                        [&](size_t y_begin, size_t y_end) {
+                            for (size_t y = y_begin; y < y_end; y++) {
+                                if (to_planar) {
+                                    DeinterleaveRow<D>(src + y * src_stride,
+                                                       dst + y * m_stride, w,
+                                                       d, plane_stride);
+                                } else {
+                                    InterleaveRow<D>(src + y * src_stride,
+                                                     dst + y * m_stride, w, d,
+                                                     plane_stride);
+                                }
+                            }
+                        },
+                        n_worker);
+        });
+    }
+
     // -------------------------------------------------------------------------
-    void load(const std::string& filename) {
-        // Load with STB
-        int w_i, h_i, d_i;
-        uint8_t* data = stbi_load(filename.c_str(), &w_i, &h_i, &d_i, 0);
-        if (!data) {
-            throw std::runtime_error("Failed to load: " + filename);
+    void load(const std::string& filename, size_t n_worker) {
+        if (GetImageFormat(filename) == ImageFormat::NATIVE) {
+            // Zero-copy if possible
+            loadNative(filename, n_worker);
+            return;
         }
-        // Allocate
-        const size_t w = static_cast<size_t>(w_i);
-        const size_t h = static_cast<size_t>(h_i);
-        const size_t d = static_cast<size_t>(d_i);
-        init(w, h, d);
-        // Cast and set
-        foreach (
-                [&data, w, h, d](size_t x, size_t y, size_t z, T& v) {
-                    // y-flip
-                    const size_t idx = (w * (h - y - 1) + x) * d + z;
-                    v = CastFromUint8<T>(data[idx]);
-                },
-                0)
-            ;
-        // Free
-        stbi_image_free(data);
-    }
-
-    void save(const std::string& filename) {
-        // Cast
-        FastArray<uint8_t> u8_img(m_w * m_h * m_d);
-        foreach (
-                [this, &u8_img](size_t x, size_t y, size_t z, const T& v) {
-                    // y-flip
-                    const size_t idx = (m_w * (m_h - y - 1) + x) * m_d + z;
-                    u8_img.data()[idx] = CastToUint8(v);
-                },
-                0)
-            ;
-        // Save with STB
-        const int ret = stbi_write_jpg(filename.c_str(), m_w, m_h, m_d,
-                                       u8_img.data(), 90);
-        if (!ret) {
-            throw std::runtime_error("Failed to save: " + filename);
+        // Decode in the precision of the file as far as `T` can hold.
+        // (uint8_t images are left to STB's conversion as before)
+        const char* c_filename = filename.c_str();
+        if (IsFloatingValue<T>() && stbi_is_hdr(c_filename)) {
+            loadAs<float>(filename, stbi_loadf, n_worker);
+        } else if (!std::is_same<T, uint8_t>::value &&
+                   stbi_is_16_bit(c_filename)) {
+            loadAs<uint16_t>(filename, stbi_load_16, n_worker);
+        } else {
+            loadAs<uint8_t>(filename, stbi_load, n_worker);
+        }
+    }
+
+    void map(const std::string& filename, ImageMapMode mode) {
+        const bool writable = (mode == ImageMapMode::COPY_ON_WRITE);
+        auto file = MappedFile::Open(filename, writable);
+        const NativeImageHeader header = ReadNativeHeader(*file, filename);
+        if (header.type != GetNativeType<T>()) {
+            throw std::runtime_error("Type mismatch to map: " + filename);
+        }
+        attach(header, file, !writable);
+    }
+
+    void save(const std::string& filename,
+              const ImageSaveOptions& options) const {
+        ImageFormat format = options.format;
+        if (format == ImageFormat::AUTO) {
+            format = GetImageFormat(filename);
+        }
+        if (m_layout == ImageLayout::PLANAR) {
+            // Files are interleaved
+            Impl interleaved(*this);
+            interleaved.setLayout(ImageLayout::INTERLEAVED);
+            interleaved.save(filename, options);
+            return;
+        }
+        if (format == ImageFormat::PFM) {
+            savePfm(filename);
+        } else if (format == ImageFormat::RAW) {
+            saveRaw(filename);
+        } else if (format == ImageFormat::NATIVE) {
+            saveNative(filename);
+        } else {
+            saveStb(filename, format, options);
         }
     }
 
     // -------------------------------------------------------------------------
+    const T* data() const {
+        return m_pixels->array->data();
+    }
+
     T* data() {
-        return m_array.data();
+        detach();
+        markDirty();
+        return m_pixels->array->data();
+    }
+
+    const T& at(size_t x, size_t y, size_t z) const {
+        return (*m_pixels->array)[index(x, y, z)];
     }
 
     T& at(size_t x, size_t y, size_t z) {
-        return m_array[(y * m_w + x) * m_d + z];
+        detach();
+        if (!m_dirty.isAll()) {
+            m_dirty.mark(x / DIRTY_TILE_SIZE, y / DIRTY_TILE_SIZE);
+        }
+        return (*m_pixels->array)[index(x, y, z)];
+    }
+
+    CpuImageView<const T> view() const {
+        checkViewable();
+        const auto& array = m_pixels->array;
+        return {array, array->data(), m_w, m_h, m_d, m_stride};
+    }
+
+    CpuImageView<T> view() {
+        markDirty();
+        return viewUntracked();
+    }
+
+    CpuImageView<T> view(size_t x, size_t y, size_t w, size_t h) {
+        auto sub_view = viewUntracked().view(x, y, w, h);
+        markDirty(x, y, w, h);
+        return sub_view;
     }
 
     // -------------------------------------------------------------------------
-    void foreach (std::function<void(size_t x, size_t y, size_t z, T& v)> func,
-                  size_t n_worker) {
-        if (n_worker <= 0) {
-            n_worker = std::thread::hardware_concurrency();
+    void markDirty() {
+        m_dirty.markAll();
+    }
+
+    void markDirty(size_t x, size_t y, size_t w, size_t h) {
+        if (m_dirty.isAll() || w == 0 || h == 0 || m_w <= x || m_h <= y) {
+            return;
         }
-        if (n_worker == 1) {
-            ForeachSimple(m_array, m_w, m_h, m_d, func);
-        } else {
-            ForeachThread(m_array, m_w, m_h, m_d, func, n_worker);
+        const size_t tx_end = (std::min(x + w, m_w) - 1) / DIRTY_TILE_SIZE;
+        const size_t ty_end = (std::min(y + h, m_h) - 1) / DIRTY_TILE_SIZE;
+        for (size_t ty = y / DIRTY_TILE_SIZE; ty <= ty_end; ty++) {
+            for (size_t tx = x / DIRTY_TILE_SIZE; tx <= tx_end; tx++) {
+                m_dirty.mark(tx, ty);
+            }
         }
     }
 
-    void foreach (std::function<void(size_t x, size_t y, T* channel_vs)> func,
-                  size_t n_worker) {
-        if (n_worker <= 0) {
-            n_worker = std::thread::hardware_concurrency();
+    void clearDirty() {
+        m_dirty.clear((m_w + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE,
+                      (m_h + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE);
+    }
+
+    bool isDirty() const {
+        if (m_dirty.isAll()) {
+            return true;
         }
-        if (n_worker == 1) {
-            ForeachSimple(m_array, m_w, m_h, m_d, func);
-        } else {
-            ForeachThread(m_array, m_w, m_h, m_d, func, n_worker);
+        for (size_t ty = 0; ty < m_dirty.getCountY(); ty++) {
+            for (size_t tx = 0; tx < m_dirty.getCountX(); tx++) {
+                if (m_dirty.isMarked(tx, ty)) {
+                    return true;
+                }
+            }
         }
+        return false;
+    }
+
+    std::vector<ImageRect> getDirtyRects() const {
+        std::vector<ImageRect> rects;
+        if (m_w == 0 || m_h == 0) {
+            return rects;
+        } else if (m_dirty.isAll()) {
+            rects.push_back({0, 0, m_w, m_h});
+            return rects;
+        }
+        // Runs of tiles in each tile row, extending the same runs above
+        const size_t n_tile_x = m_dirty.getCountX();
+        std::vector<size_t> above, current;  // Indices of `rects`
+        for (size_t ty = 0; ty < m_dirty.getCountY(); ty++) {
+            current.clear();
+            for (size_t tx = 0; tx < n_tile_x;) {
+                if (!m_dirty.isMarked(tx, ty)) {
+                    tx++;
+                    continue;
+                }
+                const size_t tx_begin = tx;
+                while (tx < n_tile_x && m_dirty.isMarked(tx, ty)) {
+                    tx++;
+                }
+                const size_t x = tx_begin * DIRTY_TILE_SIZE;
+                const size_t w = std::min(tx * DIRTY_TILE_SIZE, m_w) - x;
+                const size_t y = ty * DIRTY_TILE_SIZE;
+                const size_t h = std::min(y + DIRTY_TILE_SIZE, m_h) - y;
+                auto it = std::find_if(above.begin(), above.end(),
+                                       [&](size_t i) {
+                                           return rects[i].x == x &&
+                                                  rects[i].w == w;
+                                       });
+                if (it != above.end()) {
+                    rects[*it].h += h;
+                    current.push_back(*it);
+                } else {
+                    current.push_back(rects.size());
+                    rects.push_back({x, y, w, h});
+                }
+            }
+            std::swap(above, current);
+        }
+        return rects;
+    }
+
+    uint64_t getSyncId() const {
+        return m_sync_id;
+    }
+
+    uint64_t markSynced() {
+        clearDirty();
+        m_sync_id = NewSyncId();
+        return m_sync_id;
+    }
+
+    // -------------------------------------------------------------------------
+    template <typename F>
+    void foreach (F func, size_t n_worker, ForeachTile tile = {}) {
+        detach();
+        markDirty();
+        ForeachPixels(m_pixels->array->data(), m_w, m_h, m_d, m_stride,
+                      m_layout, func, n_worker, tile);
+    }
+
+    template <typename F>
+    void foreach (F func, size_t n_worker, ForeachTile tile = {}) const {
+        const T* data = m_pixels->array->data();
+        ForeachPixels(data, m_w, m_h, m_d, m_stride, m_layout, func, n_worker,
+                      tile);
     }
 
     // -------------------------------------------------------------------------
 private:
+    void saveStb(const std::string& filename, ImageFormat format,
+                 const ImageSaveOptions& options) const {
+        // y-flip and cast to uint8_t row by row
+        const size_t row_size = m_w * m_d;
+        FastArray<uint8_t> u8_img(row_size * m_h);
+        const T* src = m_pixels->array->data();
+        uint8_t* dst = u8_img.data();
+        const float scale = 255.f / GetValueRange<T>();
+        const size_t n_worker = (row_size * m_h < CONVERT_INLINE_SIZE) ? 1 : 0;
+        ParallelFor(m_h,
+                    [&](size_t y_begin, size_t y_end) {
+                        for (size_t y = y_begin; y < y_end; y++) {
+                            ConvertRow(src + y * m_stride,
+                                       dst + (m_h - y - 1) * row_size,
+                                       row_size, scale, 0.f);
+                        }
+                    },
+                    n_worker);
+
+        // Save with STB
+        const char* c_filename = filename.c_str();
+        const int w = static_cast<int>(m_w);
+        const int h = static_cast<int>(m_h);
+        const int d = static_cast<int>(m_d);
+        int ret = 0;
+        if (format == ImageFormat::PNG) {
+            // The level is a global of STB
+            static std::mutex s_png_mutex;
+            std::lock_guard<std::mutex> lock(s_png_mutex);
+            stbi_write_png_compression_level = options.png_compression;
+            ret = stbi_write_png(c_filename, w, h, d, dst, w * d);
+        } else if (format == ImageFormat::BMP) {
+            ret = stbi_write_bmp(c_filename, w, h, d, dst);
+        } else if (format == ImageFormat::TGA) {
+            ret = stbi_write_tga(c_filename, w, h, d, dst);
+        } else {
+            ret = stbi_write_jpg(c_filename, w, h, d, dst,
+                                 options.jpeg_quality);
+        }
+        if (!ret) {
+            throw std::runtime_error("Failed to save: " + filename);
+        }
+    }
+
+    void savePfm(const std::string& filename) const {
+        if (m_d != 1 && m_d != 3) {
+            throw std::runtime_error("PFM needs 1 or 3 channels: " + filename);
+        }
+        // Header (negative scale means little endian)
+        const std::string header = std::string(m_d == 3 ? "PF" : "Pf") +
+                                   "\n" + std::to_string(m_w) + " " +
+                                   std::to_string(m_h) + "\n" +
+                                   (IsLittleEndian() ? "-1.0" : "1.0") + "\n";
+        FilePtr file = OpenFile(filename, "wb");
+        WriteFile(file, header.data(), header.size(), filename);
+
+        // Rows are bottom-to-top as this image
+        const size_t row_size = m_w * m_d;
+        FastArray<float> row_buf;
+        for (size_t y = 0; y < m_h; y++) {
+            const T* row = m_pixels->array->data() + y * m_stride;
+            const float* f_row = reinterpret_cast<const float*>(row);
+            if (!std::is_same<T, float>::value) {
+                // Normalize to [0, 1]
+                row_buf.resize(row_size);
+                ConvertRow(row, row_buf.data(), row_size,
+                           1.f / GetValueRange<T>(), 0.f);
+                f_row = row_buf.data();
+            }
+            WriteFile(file, f_row, row_size * sizeof(float), filename);
+        }
+    }
+
+    void saveRaw(const std::string& filename) const {
+        // Stream rows directly from the pixels (without padding)
+        FilePtr file = OpenFile(filename, "wb");
+        const size_t row_bytes = m_w * m_d * sizeof(T);
+        if (m_stride == m_w * m_d) {
+            WriteFile(file, m_pixels->array->data(), row_bytes * m_h, filename);
+        } else {
+            for (size_t y = 0; y < m_h; y++) {
+                WriteFile(file, m_pixels->array->data() + y * m_stride,
+                          row_bytes, filename);
+            }
+        }
+    }
+
+    void saveNative(const std::string& filename) const {
+        NativeImageHeader header = {};
+        std::memcpy(header.magic, NATIVE_MAGIC, sizeof(NATIVE_MAGIC));
+        header.version = NATIVE_VERSION;
+        header.type = GetNativeType<T>();
+        header.width = m_w;
+        header.height = m_h;
+        header.depth = m_d;
+        header.row_stride = m_stride;
+        header.payload_offset = sizeof(header);
+        // Pixels are written as they are
+        FilePtr file = OpenFile(filename, "wb");
+        WriteFile(file, &header, sizeof(header), filename);
+        WriteFile(file, m_pixels->array->data(), m_stride * m_h * sizeof(T),
+                  filename);
+    }
+
+    void loadNative(const std::string& filename, size_t n_worker) {
+        auto file = MappedFile::Open(filename, true);
+        const NativeImageHeader header = ReadNativeHeader(*file, filename);
+        if (header.type == GetNativeType<T>()) {
+            // Private mapping behaves as a loaded image
+            attach(header, file, false);
+            return;
+        }
+        switch (header.type) {
+            case NATIVE_UINT8:
+                convertNative<uint8_t>(header, *file, n_worker);
+                break;
+            case NATIVE_UINT16:
+                convertNative<uint16_t>(header, *file, n_worker);
+                break;
+            case NATIVE_FLOAT32:
+                convertNative<float>(header, *file, n_worker);
+                break;
+            case NATIVE_FLOAT16:
+                convertNative<Float16>(header, *file, n_worker);
+                break;
+        }
+    }
+
+    template <typename S>
+    void convertNative(const NativeImageHeader& header, const MappedFile& file,
+                       size_t n_worker) {
+        const size_t w = static_cast<size_t>(header.width);
+        const size_t h = static_cast<size_t>(header.height);
+        const size_t d = static_cast<size_t>(header.depth);
+        const size_t stride = static_cast<size_t>(header.row_stride);
+        init(w, h, d);
+        const S* src = reinterpret_cast<const S*>(file.data() +
+                                                  header.payload_offset);
+        T* dst = m_pixels->array->data();
+        const float scale = GetValueRange<T>() / GetValueRange<S>();
+        if (w * h * d < CONVERT_INLINE_SIZE) {
+            n_worker = 1;
+        }
+        ParallelFor(h,
+                    [&](size_t y_begin, size_t y_end) {
+                        for (size_t y = y_begin; y < y_end; y++) {
+                            ConvertRow(src + y * stride, dst + y * m_stride,
+                                       w * d, scale, 0.f);
+                        }
+                    },
+                    n_worker);
+    }
+
+    void attach(const NativeImageHeader& header,
+                const std::shared_ptr<MappedFile>& file, bool read_only) {
+        m_w = static_cast<size_t>(header.width);
+        m_h = static_cast<size_t>(header.height);
+        m_d = static_cast<size_t>(header.depth);
+        m_stride = static_cast<size_t>(header.row_stride);
+        m_row_align = 0;
+        m_layout = ImageLayout::INTERLEAVED;
+        T* data = reinterpret_cast<T*>(file->data() + header.payload_offset);
+        // Leave the shared pixels to the others
+        m_pixels = std::make_shared<SharedPixels>();
+        m_pixels->array->attach(data, m_stride * m_h, file, read_only);
+        markDirty();
+    }
+
+    template <typename S, typename LoadFunc>
+    void loadAs(const std::string& filename, LoadFunc load_func,
+                size_t n_worker) {
+        // Load with STB
+        int w_i, h_i, d_i;
+        std::unique_ptr<S, void (*)(void*)> data(
+                load_func(filename.c_str(), &w_i, &h_i, &d_i, 0),
+                stbi_image_free);
+        if (!data) {
+            throw std::runtime_error("Failed to load: " + filename);
+        }
+        // Allocate (reuses the current pixels if possible)
+        const size_t w = static_cast<size_t>(w_i);
+        const size_t h = static_cast<size_t>(h_i);
+        const size_t d = static_cast<size_t>(d_i);
+        init(w, h, d);
+        // y-flip and cast row by row in a single pass
+        // (memcpy for the same type, SIMD conversion for others)
+        const size_t row_size = w * d;
+        const S* src = data.get();
+        T* dst = m_pixels->array->data();
+        const float scale = GetValueRange<T>() / GetValueRange<S>();
+        if (row_size * h < CONVERT_INLINE_SIZE) {
+            n_worker = 1;
+        }
+        ParallelFor(h,
+                    [&](size_t y_begin, size_t y_end) {
+                        for (size_t y = y_begin; y < y_end; y++) {
+                            ConvertRow(src + (h - y - 1) * row_size,
+                                       dst + y * m_stride, row_size, scale,
+                                       0.f);
+                        }
+                    },
+                    n_worker);
+    }
+
+    size_t index(size_t x, size_t y, size_t z) const {
+        if (m_layout == ImageLayout::PLANAR) {
+            return (z * m_h + y) * m_stride + x;
+        }
+        return y * m_stride + x * m_d + z;
+    }
+
+    CpuImageView<T> viewUntracked() {
+        checkViewable();
+        detach();
+        // Not shared with later copies, which would see writes of the view
+        m_pixels->unshareable = true;
+        const auto& array = m_pixels->array;
+        return {array, array->data(), m_w, m_h, m_d, m_stride};
+    }
+
+    void checkViewable() const {
+        if (m_layout == ImageLayout::PLANAR) {
+            throw std::runtime_error("Planar image cannot be viewed");
+        }
+    }
+
+    void detach() {
+        // Copy-on-write: clone the pixels before modifying shared ones
+        // (or read-only mapped ones)
+        if (m_pixels.use_count() != 1 || m_pixels->array->isReadOnly()) {
+            auto pixels = std::make_shared<SharedPixels>();
+            pixels->array = std::make_shared<PixelArray<T>>(*m_pixels->array);
+            m_pixels = std::move(pixels);
+        }
+    }
+
     size_t m_w = 0, m_h = 0, m_d = 0;
-    FastArray<T> m_array;
+    size_t m_stride = 0;
+    size_t m_row_align = 0;
+    ImageLayout m_layout = ImageLayout::INTERLEAVED;
+    // Shared between copies until the first mutable access. Views refer to
+    // `array` directly, so that they are not counted as copies.
+    struct SharedPixels {
+        std::shared_ptr<PixelArray<T>> array =
+                std::make_shared<PixelArray<T>>();
+        bool unshareable = false;  // Once a mutable view is taken
+    };
+    std::shared_ptr<SharedPixels> m_pixels = std::make_shared<SharedPixels>();
+
+    // Written tiles since the last upload, which are copied with the pixels
+    // because copies have the same contents
+    DirtyTiles m_dirty;
+    uint64_t m_sync_id = 0;
 };
 
 // -----------------------------------------------------------------------------
@@ -285,6 +953,11 @@ template <typename T>
 CpuImage<T>::CpuImage(size_t w, size_t h, size_t d)
     : m_impl(std::make_unique<Impl>(w, h, d)) {}
 
+template <typename T>
+CpuImage<T>::CpuImage(size_t w, size_t h, size_t d, size_t row_align,
+                      ImageLayout layout)
+    : m_impl(std::make_unique<Impl>(w, h, d, row_align, layout)) {}
+
 template <typename T>
 CpuImage<T>::CpuImage(const CpuImage& lhs)
     : m_impl(std::make_unique<Impl>(*lhs.m_impl)) {}
@@ -316,13 +989,62 @@ GpuImagePtr<T> CpuImage<T>::toGpu() const {
 template <typename T>
 void CpuImage<T>::fromGpu(const GpuImagePtr<T>& gpu_img) {
     // Just use GpuImage's implementation
-    *this = *gpu_img->toCpu();
+    fromGpu(*gpu_img);
 }
 
 template <typename T>
 void CpuImage<T>::fromGpu(const GpuImage<T>& gpu_img) {
-    // Just use GpuImage's implementation
-    *this = *gpu_img.toCpu();
+    // Just use GpuImage's implementation (steal the temporary)
+    auto cpu_img = gpu_img.toCpu();
+    if (cpu_img) {
+        *this = std::move(*cpu_img);
+    } else {
+        init(0, 0, 0);
+    }
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+template <typename U>
+CpuImagePtr<U> CpuImage<T>::convertTo(float scale, float bias) const {
+    const Impl& impl = *m_impl;
+    const size_t w = impl.getWidth(), h = impl.getHeight();
+    const size_t d = impl.getDepth(), stride = impl.getRowStride();
+    const ImageLayout layout = impl.getLayout();
+    auto dst_img = CpuImage<U>::Create(w, h, d, size_t(0), layout);
+    const T* src = impl.data();
+    U* dst = dst_img->data();
+
+    // Dense rows are converted as one long row
+    size_t n_row = h, row_size = w * d;
+    if (layout == ImageLayout::PLANAR) {
+        n_row = h * d;
+        row_size = w;
+    }
+    if (stride == row_size) {
+        row_size *= n_row;
+        n_row = 1;
+    }
+    if (n_row == 0 || row_size == 0) {
+        return dst_img;
+    }
+    // Split each row into chunks
+    const size_t n_chunk = (row_size + CONVERT_CHUNK_SIZE - 1) /
+                           CONVERT_CHUNK_SIZE;
+    const size_t n_worker = (w * h * d < CONVERT_INLINE_SIZE) ? 1 : 0;
+    ParallelFor(n_row * n_chunk,
+                [&](size_t t_begin, size_t t_end) {
+                    for (size_t t = t_begin; t < t_end; t++) {
+                        const size_t y = t / n_chunk;
+                        const size_t x = (t % n_chunk) * CONVERT_CHUNK_SIZE;
+                        const size_t n =
+                                std::min(CONVERT_CHUNK_SIZE, row_size - x);
+                        ConvertRow(src + y * stride + x, dst + y * row_size + x,
+                                   n, scale, bias);
+                    }
+                },
+                n_worker);
+    return dst_img;
 }
 
 // -----------------------------------------------------------------------------
@@ -351,21 +1073,60 @@ size_t CpuImage<T>::getDepth() const {
     return m_impl->getDepth();
 }
 
+template <typename T>
+void CpuImage<T>::init(size_t w, size_t h, size_t d, size_t row_align,
+                       ImageLayout layout) {
+    m_impl->init(w, h, d, row_align, layout);
+}
+
+template <typename T>
+size_t CpuImage<T>::getRowStride() const {
+    return m_impl->getRowStride();
+}
+
+template <typename T>
+ImageLayout CpuImage<T>::getLayout() const {
+    return m_impl->getLayout();
+}
+
+template <typename T>
+void CpuImage<T>::setLayout(ImageLayout layout) {
+    m_impl->setLayout(layout);
+}
+
 // -----------------------------------------------------------------------------
 template <typename T>
 void CpuImage<T>::load(const std::string& filename) {
-    m_impl->load(filename);
+    m_impl->load(filename, 0);
+}
+
+template <typename T>
+void CpuImage<T>::load(const std::string& filename, size_t n_worker) {
+    m_impl->load(filename, n_worker);
+}
+
+template <typename T>
+void CpuImage<T>::map(const std::string& filename, ImageMapMode mode) {
+    m_impl->map(filename, mode);
 }
 
 template <typename T>
 void CpuImage<T>::save(const std::string& filename) const {
-    m_impl->save(filename);
+    m_impl->save(filename, {});
+}
+
+template <typename T>
+void CpuImage<T>::save(const std::string& filename,
+                       const ImageSaveOptions& options) const {
+    m_impl->save(filename, options);
 }
 
 // -----------------------------------------------------------------------------
 template <typename T>
 const T* CpuImage<T>::data() const {
-    return m_impl->data();
+    // Through const Impl not to detach the shared pixels
+    const Impl& impl = *m_impl;
+    return impl.data();
 }
 
 template <typename T>
@@ -375,7 +1136,8 @@ T* CpuImage<T>::data() {
 
 template <typename T>
 const T& CpuImage<T>::at(size_t x, size_t y, size_t z) const {
-    return m_impl->at(x, y, z);
+    const Impl& impl = *m_impl;
+    return impl.at(x, y, z);
 }
 
 template <typename T>
@@ -383,35 +1145,164 @@ T& CpuImage<T>::at(size_t x, size_t y, size_t z) {
     return m_impl->at(x, y, z);
 }
 
+// -----------------------------------------------------------------------------
+template <typename T>
+CpuImageView<T> CpuImage<T>::view() {
+    return m_impl->view();
+}
+
+template <typename T>
+CpuImageView<const T> CpuImage<T>::view() const {
+    const Impl& impl = *m_impl;
+    return impl.view();
+}
+
+template <typename T>
+CpuImageView<T> CpuImage<T>::view(size_t x, size_t y, size_t w, size_t h) {
+    return m_impl->view(x, y, w, h);
+}
+
+template <typename T>
+CpuImageView<const T> CpuImage<T>::view(size_t x, size_t y, size_t w,
+                                        size_t h) const {
+    return view().view(x, y, w, h);
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+void CpuImage<T>::markDirty() {
+    m_impl->markDirty();
+}
+
+template <typename T>
+void CpuImage<T>::markDirty(size_t x, size_t y, size_t w, size_t h) {
+    m_impl->markDirty(x, y, w, h);
+}
+
+template <typename T>
+void CpuImage<T>::clearDirty() {
+    m_impl->clearDirty();
+}
+
+template <typename T>
+bool CpuImage<T>::isDirty() const {
+    return m_impl->isDirty();
+}
+
+template <typename T>
+std::vector<ImageRect> CpuImage<T>::getDirtyRects() const {
+    return m_impl->getDirtyRects();
+}
+
+template <typename T>
+uint64_t CpuImage<T>::getSyncId() const {
+    return m_impl->getSyncId();
+}
+
+template <typename T>
+uint64_t CpuImage<T>::markSynced() {
+    return m_impl->markSynced();
+}
+
 // -----------------------------------------------------------------------------
 template <typename T>
 void CpuImage<T>::foreach (
         std::function<void(size_t x, size_t y, size_t z, T& v)> func,
-        size_t n_worker) {
-    m_impl->foreach (func, n_worker);
+        size_t n_worker, ForeachTile tile) {
+    m_impl->foreach (func, n_worker, tile);
 }
 
 template <typename T>
 void CpuImage<T>::foreach (
         std::function<void(size_t x, size_t y, size_t z, const T& v)> func,
-        size_t n_worker) const {
-    m_impl->foreach (func, n_worker);
+        size_t n_worker, ForeachTile tile) const {
+    const Impl& impl = *m_impl;
+    impl.foreach (func, n_worker, tile);
 }
 
 template <typename T>
 void CpuImage<T>::foreach (
         std::function<void(size_t x, size_t y, T* channel_vs)> func,
-        size_t n_worker) {
-    m_impl->foreach (func, n_worker);
+        size_t n_worker, ForeachTile tile) {
+    m_impl->foreach (func, n_worker, tile);
 }
 
 template <typename T>
 void CpuImage<T>::foreach (
         std::function<void(size_t x, size_t y, const T* channel_vs)> func,
-        size_t n_worker) const {
-    m_impl->foreach (func, n_worker);
+        size_t n_worker, ForeachTile tile) const {
+    const Impl& impl = *m_impl;
+    impl.foreach (func, n_worker, tile);
 }
 
+// ================================ Batch Load =================================
+template <typename T>
+std::vector<CpuImagePtr<T>> LoadImages(
+        const std::vector<std::string>& filenames,
+        std::vector<std::string>* errors, size_t n_worker) {
+    const size_t n_file = filenames.size();
+    std::vector<CpuImagePtr<T>> images(n_file);
+    std::vector<std::string> messages(n_file);
+    if (n_worker == 0) {
+        n_worker = GetParallelWorkerCount() + 1;
+    }
+    n_worker = std::max(std::min(n_worker, n_file), size_t(1));
+
+    // Files next to the ones being decoded are read by the OS meanwhile
+    const size_t n_ahead = std::min(n_worker * 2, n_file);
+    for (size_t i = 0; i < n_ahead; i++) {
+        PrefetchFile(filenames[i]);
+    }
+    std::atomic<size_t> next_idx{0};
+    ParallelFor(n_worker, [&](size_t, size_t) {
+        for (size_t i = next_idx++; i < n_file; i = next_idx++) {
+            if (i + n_ahead < n_file) {
+                PrefetchFile(filenames[i + n_ahead]);
+            }
+            try {
+                // One file for each worker, so convert in this thread
+                auto img = CpuImage<T>::Create();
+                img->load(filenames[i], 1);
+                images[i] = std::move(img);
+            } catch (const std::exception& e) {
+                messages[i] = e.what();
+            }
+        }
+    }, n_worker);
+
+    if (errors) {
+        *errors = std::move(messages);
+    }
+    return images;
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ Specialization -------------------------------
+// -----------------------------------------------------------------------------
+#define OGLW_INSTANTIATE_CONVERT_TO(T, U) \
+    template CpuImagePtr<U> CpuImage<T>::convertTo<U>(float, float) const;
+#define OGLW_INSTANTIATE_CONVERT_TO_ALL(T)   \
+    OGLW_INSTANTIATE_CONVERT_TO(T, uint8_t)  \
+    OGLW_INSTANTIATE_CONVERT_TO(T, uint16_t) \
+    OGLW_INSTANTIATE_CONVERT_TO(T, float)    \
+    OGLW_INSTANTIATE_CONVERT_TO(T, Float16)
+OGLW_INSTANTIATE_CONVERT_TO_ALL(uint8_t)
+OGLW_INSTANTIATE_CONVERT_TO_ALL(uint16_t)
+OGLW_INSTANTIATE_CONVERT_TO_ALL(float)
+OGLW_INSTANTIATE_CONVERT_TO_ALL(Float16)
+#undef OGLW_INSTANTIATE_CONVERT_TO_ALL
+#undef OGLW_INSTANTIATE_CONVERT_TO
+
+#define OGLW_INSTANTIATE_LOAD_IMAGES(T)                                 \
+    template std::vector<CpuImagePtr<T>> LoadImages<T>(                 \
+            const std::vector<std::string>&, std::vector<std::string>*, \
+            size_t);
+OGLW_INSTANTIATE_LOAD_IMAGES(uint8_t)
+OGLW_INSTANTIATE_LOAD_IMAGES(uint16_t)
+OGLW_INSTANTIATE_LOAD_IMAGES(float)
+OGLW_INSTANTIATE_LOAD_IMAGES(Float16)
+#undef OGLW_INSTANTIATE_LOAD_IMAGES
+
 // -----------------------------------------------------------------------------
 
 }  // namespace oglw
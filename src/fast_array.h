@@ -1,17 +1,36 @@
 #ifndef FAST_ARRAY_H_190209
 #define FAST_ARRAY_H_190209
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <memory>
 
+#include <oglw/memory_pool.h>
+#include <oglw/parallel.h>
+
 namespace oglw {
 
-template <typename T>
+// Arrays larger than this are filled and copied on the thread pool, so that
+// first-touch of pages is spread over workers. (By `ParallelForPinned()`,
+// which places them on NUMA nodes of the workers running `CpuImage::foreach`)
+constexpr size_t FAST_ARRAY_PARALLEL_BYTES = PARALLEL_PINNED_BYTES;
+constexpr size_t FAST_ARRAY_PAGE_BYTES = 4096;
+
+// Head of the array is aligned to `Align` bytes (default: cache line size)
+template <typename T, size_t Align = 64>
 class FastArray {
 public:
+    static_assert(0 < Align && (Align & (Align - 1)) == 0,
+                  "Alignment must be power of two");
+    static_assert(alignof(T) <= Align, "Alignment must cover the type");
+
     using ValueType = T;
     using Iterator = T*;
+    using ConstIterator = const T*;
+    static constexpr size_t ALIGNMENT = Align;
 
     FastArray();
     FastArray(size_t n);
@@ -23,26 +42,52 @@ public:
     ~FastArray();
 
     void alloc(size_t n);  // Allocate without copy
-    void clear();
+    void clear();          // Release the buffer
+    void reserve(size_t n);  // Extend the capacity with copy
     void resize(size_t n); // Resize with copy
     void resize(size_t n, const T& v);  // Resize with copy and fill
     void fill(const T& v);
 
+    // Point at external memory (e.g. a file mapping) without copy. `owner`
+    // keeps it alive until the array is cleared or reallocated. `data` must be
+    // aligned to `Align`. Read-only memory must not be written through data().
+    void attach(T* data, size_t n, std::shared_ptr<void> owner,
+                bool read_only);
+    bool isExternal() const;
+    bool isReadOnly() const;
+
+    // Append with geometric growth of the capacity
+    void push_back(const T& v);
+    template <typename ForwardIterator>
+    void append(ForwardIterator first, ForwardIterator last);
+
     size_t size() const;
+    size_t capacity() const;
     bool empty() const;
     const T* data() const;
     T* data();
 
     Iterator begin();
     Iterator end();
+    ConstIterator begin() const;
+    ConstIterator end() const;
 
     const T& operator[](size_t i) const;
     T& operator[](size_t i);
 
 private:
+    static size_t GetAllocBytes(size_t n);
+    template <typename F>
+    static void ParallelFor(size_t n, F func);
+    void grow(size_t n);
+    void copyFrom(const T* src, size_t n);
+
     unsigned char* m_data_uc = nullptr;
     T* m_data = nullptr;
     size_t m_size = 0;
+    size_t m_capacity = 0;
+    std::shared_ptr<void> m_external;  // Owner of external memory
+    bool m_read_only = false;
 };
 
 #include "fast_array_impl.h"
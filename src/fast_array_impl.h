@@ -1,165 +1,291 @@
 #include "fast_array.h"
 
-template <typename T>
-FastArray<T>::FastArray() {}
+template <typename T, size_t Align>
+constexpr size_t FastArray<T, Align>::ALIGNMENT;
 
-template <typename T>
-FastArray<T>::FastArray(size_t n) {
+template <typename T, size_t Align>
+FastArray<T, Align>::FastArray() {}
+
+template <typename T, size_t Align>
+FastArray<T, Align>::FastArray(size_t n) {
     alloc(n);
 }
-template <typename T>
-FastArray<T>::FastArray(size_t n, const T& v) {
+template <typename T, size_t Align>
+FastArray<T, Align>::FastArray(size_t n, const T& v) {
     alloc(n);
     fill(v);
 }
 
-template <typename T>
-FastArray<T>::FastArray(const FastArray<T>& lhs) {
+template <typename T, size_t Align>
+FastArray<T, Align>::FastArray(const FastArray<T, Align>& lhs) {
     alloc(lhs.size());
-    memcpy(m_data_uc, lhs.m_data_uc, m_size * sizeof(T));
+    copyFrom(lhs.m_data, m_size);
 }
 
-template <typename T>
-FastArray<T>& FastArray<T>::operator=(const FastArray<T>& lhs) {
-    alloc(lhs.size());
-    memcpy(m_data_uc, lhs.m_data_uc, m_size * sizeof(T));
+template <typename T, size_t Align>
+FastArray<T, Align>& FastArray<T, Align>::operator=(
+        const FastArray<T, Align>& lhs) {
+    if (this != &lhs) {
+        alloc(lhs.size());
+        copyFrom(lhs.m_data, m_size);
+    }
     return *this;
 }
 
-template <typename T>
-FastArray<T>::FastArray(FastArray<T>&& lhs) noexcept {
+template <typename T, size_t Align>
+FastArray<T, Align>::FastArray(FastArray<T, Align>&& lhs) noexcept {
     // Move pointers
     m_data_uc = lhs.m_data_uc;
     m_data = lhs.m_data;
     m_size = lhs.m_size;
+    m_capacity = lhs.m_capacity;
+    m_external = std::move(lhs.m_external);
+    m_read_only = lhs.m_read_only;
     // Clear the other side
     lhs.m_data_uc = nullptr;
     lhs.m_data = nullptr;
     lhs.m_size = 0;
+    lhs.m_capacity = 0;
+    lhs.m_read_only = false;
 }
 
-template <typename T>
-FastArray<T>& FastArray<T>::operator=(FastArray<T>&& lhs) noexcept {
+template <typename T, size_t Align>
+FastArray<T, Align>& FastArray<T, Align>::operator=(
+        FastArray<T, Align>&& lhs) noexcept {
     clear();
     // Move pointers
     m_data_uc = lhs.m_data_uc;
     m_data = lhs.m_data;
     m_size = lhs.m_size;
+    m_capacity = lhs.m_capacity;
+    m_external = std::move(lhs.m_external);
+    m_read_only = lhs.m_read_only;
     // Clear the other side
     lhs.m_data_uc = nullptr;
     lhs.m_data = nullptr;
     lhs.m_size = 0;
+    lhs.m_capacity = 0;
+    lhs.m_read_only = false;
     return *this;
 }
 
-template <typename T>
-FastArray<T>::~FastArray() {
+template <typename T, size_t Align>
+FastArray<T, Align>::~FastArray() {
     clear();
 }
 
-template <typename T>
-void FastArray<T>::alloc(size_t n) {
-    if (m_size == n) {
+template <typename T, size_t Align>
+void FastArray<T, Align>::alloc(size_t n) {
+    if (n <= m_capacity && !m_external) {
+        // Reuse the current buffer
+        m_size = n;
         return;
     }
 
     clear();
-    if (0 < n) {
-        m_data_uc = new unsigned char[n * sizeof(T)];
-        m_data = reinterpret_cast<T*>(m_data_uc);
-        m_size = n;
-    }
+    // Over-allocate to shift the head onto the alignment boundary
+    m_data_uc = PoolAllocate(GetAllocBytes(n));
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(m_data_uc);
+    m_data = reinterpret_cast<T*>((addr + Align - 1) & ~(Align - 1));
+    m_size = n;
+    m_capacity = n;
 }
 
-template <typename T>
-void FastArray<T>::clear() {
-    if (m_size != 0) {
-        delete[] m_data_uc;
+template <typename T, size_t Align>
+void FastArray<T, Align>::clear() {
+    if (m_data_uc) {
+        PoolFree(m_data_uc, GetAllocBytes(m_capacity));
         m_data_uc = nullptr;
-        m_data = nullptr;
-        m_size = 0;
     }
+    m_external.reset();
+    m_read_only = false;
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
 }
 
-template <typename T>
-void FastArray<T>::resize(size_t n) {
-    if (m_size == n) {
+template <typename T, size_t Align>
+void FastArray<T, Align>::reserve(size_t n) {
+    if (n <= m_capacity) {
         return;
     }
 
-    if (0 < n) {
-        // Create new size array
-        FastArray<T> tmp(n);
-        // Copy
-        memcpy(tmp.m_data_uc, m_data_uc, n * sizeof(T));
-        // Overwrite
-        *this = std::move(tmp);
-    }
+    // Create new capacity array
+    FastArray<T, Align> tmp(n);
+    // Copy
+    tmp.copyFrom(m_data, m_size);
+    tmp.m_size = m_size;
+    // Overwrite
+    *this = std::move(tmp);
 }
 
-template <typename T>
-void FastArray<T>::resize(size_t n, const T& v) {
-    if (m_size == n) {
-        return;
+template <typename T, size_t Align>
+void FastArray<T, Align>::resize(size_t n) {
+    reserve(n);
+    m_size = n;
+}
+
+template <typename T, size_t Align>
+void FastArray<T, Align>::resize(size_t n, const T& v) {
+    reserve(n);
+    // Fill the left space
+    for (size_t i = m_size; i < n; i++) {
+        m_data[i] = v;
     }
+    m_size = n;
+}
 
-    if (0 < n) {
-        // Create new size array
-        FastArray<T> tmp(n);
-        // Copy
-        memcpy(tmp.m_data_uc, m_data_uc, n * sizeof(T));
-        // Fill the left space
-        for (size_t i = m_size; i < n; i++) {
-            tmp[i] = v;
-        }
-        // Overwrite
-        *this = std::move(tmp);
+template <typename T, size_t Align>
+void FastArray<T, Align>::push_back(const T& v) {
+    if (m_size == m_capacity) {
+        // Copy before growing because `v` may be in this array
+        const T tmp = v;
+        grow(m_size + 1);
+        m_data[m_size++] = tmp;
+    } else {
+        m_data[m_size++] = v;
     }
 }
 
-template <typename T>
-void FastArray<T>::fill(const T& v) {
-    for (size_t i = 0; i < m_size; i++) {
-        m_data[i] = v;
+template <typename T, size_t Align>
+template <typename ForwardIterator>
+void FastArray<T, Align>::append(ForwardIterator first,
+                                 ForwardIterator last) {
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    if (m_capacity < m_size + n) {
+        // Copy before growing because the range may be in this array
+        FastArray<T, Align> tmp(n);
+        std::copy(first, last, tmp.m_data);
+        grow(m_size + n);
+        memcpy(m_data + m_size, tmp.m_data, n * sizeof(T));
+    } else {
+        std::copy(first, last, m_data + m_size);
     }
+    m_size += n;
+}
+
+template <typename T, size_t Align>
+void FastArray<T, Align>::fill(const T& v) {
+    ParallelFor(m_size, [&](size_t begin, size_t end) noexcept {
+        for (size_t i = begin; i < end; i++) {
+            m_data[i] = v;
+        }
+    });
 }
 
-template <typename T>
-size_t FastArray<T>::size() const {
+template <typename T, size_t Align>
+void FastArray<T, Align>::attach(T* data, size_t n, std::shared_ptr<void> owner,
+                                 bool read_only) {
+    clear();
+    m_data = data;
+    m_size = n;
+    m_capacity = n;
+    m_external = std::move(owner);
+    m_read_only = read_only;
+}
+
+template <typename T, size_t Align>
+bool FastArray<T, Align>::isExternal() const {
+    return static_cast<bool>(m_external);
+}
+
+template <typename T, size_t Align>
+bool FastArray<T, Align>::isReadOnly() const {
+    return m_read_only;
+}
+
+template <typename T, size_t Align>
+size_t FastArray<T, Align>::size() const {
     return m_size;
 }
 
-template <typename T>
-bool FastArray<T>::empty() const {
+template <typename T, size_t Align>
+size_t FastArray<T, Align>::capacity() const {
+    return m_capacity;
+}
+
+template <typename T, size_t Align>
+bool FastArray<T, Align>::empty() const {
     return m_size == 0;
 }
 
-template <typename T>
-const T* FastArray<T>::data() const {
+template <typename T, size_t Align>
+const T* FastArray<T, Align>::data() const {
     return m_data;
 }
 
-template <typename T>
-T* FastArray<T>::data() {
+template <typename T, size_t Align>
+T* FastArray<T, Align>::data() {
     return m_data;
 }
 
-template <typename T>
-typename FastArray<T>::Iterator FastArray<T>::begin() {
+template <typename T, size_t Align>
+typename FastArray<T, Align>::Iterator FastArray<T, Align>::begin() {
     return m_data;
 }
 
-template <typename T>
-typename FastArray<T>::Iterator FastArray<T>::end() {
+template <typename T, size_t Align>
+typename FastArray<T, Align>::Iterator FastArray<T, Align>::end() {
     return m_data + m_size;
 }
 
-template <typename T>
-const T& FastArray<T>::operator[](size_t i) const {
+template <typename T, size_t Align>
+typename FastArray<T, Align>::ConstIterator FastArray<T, Align>::begin()
+        const {
+    return m_data;
+}
+
+template <typename T, size_t Align>
+typename FastArray<T, Align>::ConstIterator FastArray<T, Align>::end() const {
+    return m_data + m_size;
+}
+
+template <typename T, size_t Align>
+const T& FastArray<T, Align>::operator[](size_t i) const {
     return m_data[i];
 }
 
-template <typename T>
-T& FastArray<T>::operator[](size_t i) {
+template <typename T, size_t Align>
+T& FastArray<T, Align>::operator[](size_t i) {
     return m_data[i];
 }
+
+template <typename T, size_t Align>
+size_t FastArray<T, Align>::GetAllocBytes(size_t n) {
+    return n * sizeof(T) + Align - 1;
+}
+
+template <typename T, size_t Align>
+void FastArray<T, Align>::grow(size_t n) {
+    // Geometric growth for amortized O(1) appending
+    reserve(std::max(n, m_capacity * 2));
+}
+
+template <typename T, size_t Align>
+template <typename F>
+void FastArray<T, Align>::ParallelFor(size_t n, F func) {
+    // Small array in the calling thread
+    if (n * sizeof(T) < FAST_ARRAY_PARALLEL_BYTES) {
+        func(0, n);
+        return;
+    }
+
+    // Split into ranges of whole pages, so that each page is touched first
+    // by a single worker, which also visits it in `CpuImage::foreach`.
+    const size_t page_n =
+            std::max(sizeof(T), FAST_ARRAY_PAGE_BYTES) / sizeof(T);
+    const size_t n_page = (n + page_n - 1) / page_n;
+    oglw::ParallelForPinned(n_page, [&](size_t page_begin, size_t page_end) {
+        func(page_begin * page_n, std::min(page_end * page_n, n));
+    });
+}
+
+template <typename T, size_t Align>
+void FastArray<T, Align>::copyFrom(const T* src, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    ParallelFor(n, [&](size_t begin, size_t end) noexcept {
+        memcpy(m_data + begin, src + begin, (end - begin) * sizeof(T));
+    });
+}
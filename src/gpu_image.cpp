@@ -3,13 +3,22 @@
 #include <glad/glad.h>
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include <oglw/gl_utils.h>
 #include <oglw/image_utils.h>
 
+#include "image_convert.h"
+
+// Impls are defined only in this file, and may hold its local helpers
+#if defined __GNUC__ && !defined __clang__
+#pragma GCC diagnostic ignored "-Wsubobject-linkage"
+#endif
+
 namespace oglw {
 
 namespace {
@@ -31,6 +40,19 @@ GLenum GetGlInternalFmt<uint8_t>(size_t d) {
     throw std::runtime_error(ss.str());
 }
 
+template <>
+GLenum GetGlInternalFmt<uint16_t>(size_t d) {
+    switch (d) {
+        case 1: return GL_R16;
+        case 2: return GL_RG16;
+        case 3: return GL_RGB16;
+        case 4: return GL_RGBA16;
+    }
+    std::stringstream ss;
+    ss << "Invalid depth size for uint16_t: \"" << d << "\" (internal fmt)";
+    throw std::runtime_error(ss.str());
+}
+
 template <>
 GLenum GetGlInternalFmt<Float16>(size_t d) {
     switch (d) {
@@ -79,9 +101,14 @@ inline GLenum GetGlType<uint8_t>() {
     return GL_UNSIGNED_BYTE;
 }
 
+template <>
+inline GLenum GetGlType<uint16_t>() {
+    return GL_UNSIGNED_SHORT;
+}
+
 template <>
 inline GLenum GetGlType<Float16>() {
-    return GL_FLOAT;  // float16 in GPU, but float32 in CPU
+    return GL_HALF_FLOAT;
 }
 
 template <>
@@ -103,126 +130,339 @@ GLint GetGlStoreSize(size_t d) {
 }
 
 // -----------------------------------------------------------------------------
-inline void CopyTexture(GLuint src_tex_id, GLuint dst_tex_id, GLsizei src_w,
-                        GLsizei src_h, GLsizei src_d, GLint src_x = 0,
-                        GLint src_y = 0, GLint src_z = 0, GLint dst_x = 0,
-                        GLint dst_y = 0, GLint dst_z = 0) {
+GLint GetGlFilter(TextureFilter filter) {
+    switch (filter) {
+        case TextureFilter::NEAREST: return GL_NEAREST;
+        case TextureFilter::LINEAR: return GL_LINEAR;
+        case TextureFilter::NEAREST_MIPMAP_NEAREST:
+            return GL_NEAREST_MIPMAP_NEAREST;
+        case TextureFilter::LINEAR_MIPMAP_NEAREST:
+            return GL_LINEAR_MIPMAP_NEAREST;
+        case TextureFilter::NEAREST_MIPMAP_LINEAR:
+            return GL_NEAREST_MIPMAP_LINEAR;
+        case TextureFilter::LINEAR_MIPMAP_LINEAR:
+            return GL_LINEAR_MIPMAP_LINEAR;
+    }
+    throw std::runtime_error("Invalid texture filter");
+}
+
+// -----------------------------------------------------------------------------
+inline void CopyTexture(GLenum target, GLuint src_tex_id, GLuint dst_tex_id,
+                        GLsizei src_w, GLsizei src_h, GLsizei src_d,
+                        GLint level = 0, GLint src_x = 0, GLint src_y = 0,
+                        GLint src_z = 0, GLint dst_x = 0, GLint dst_y = 0,
+                        GLint dst_z = 0) {
     if (0 < src_w && 0 < src_h && 0 < src_d) {
-        OGLW_CHECK(glCopyImageSubData, src_tex_id, GL_TEXTURE_2D, 0, src_x,
-                   src_y, src_z, dst_tex_id, GL_TEXTURE_2D, 0, dst_x, dst_y,
+        OGLW_CHECK(glCopyImageSubData, src_tex_id, target, level, src_x,
+                   src_y, src_z, dst_tex_id, target, level, dst_x, dst_y,
                    dst_z, src_w, src_h, src_d);
     }
 }
 
 // -----------------------------------------------------------------------------
+// Texture helpers shared by 2D and layered images, whose `target` is
+// `GL_TEXTURE_2D`, `GL_TEXTURE_2D_ARRAY` or `GL_TEXTURE_3D`
+inline size_t GetLayerCount(GLenum target, size_t n_layer, size_t level) {
+    // Layers are halved only for 3D
+    return (target == GL_TEXTURE_3D) ? GetMipSize(n_layer, level) : n_layer;
+}
 
-}  // namespace
+// Copy all levels of same-sized textures (`n_layer` is 1 for 2D)
+void CopyTextureLevels(GLenum target, GLuint src_tex_id, GLuint dst_tex_id,
+                       size_t w, size_t h, size_t n_layer, size_t n_level) {
+    if (src_tex_id == 0 || dst_tex_id == 0) {
+        return;
+    }
+    for (size_t level = 0; level < n_level; level++) {
+        CopyTexture(target, src_tex_id, dst_tex_id,
+                    static_cast<GLsizei>(GetMipSize(w, level)),
+                    static_cast<GLsizei>(GetMipSize(h, level)),
+                    static_cast<GLsizei>(GetLayerCount(target, n_layer, level)),
+                    static_cast<GLint>(level));
+    }
+}
 
-// ================================= GPU Image =================================
+// Filters of new textures, with mipmaps if they have levels
+inline TextureFilter GetDefaultMinFilter(size_t n_level) {
+    return (n_level == 1) ? TextureFilter::NEAREST
+                          : TextureFilter::LINEAR_MIPMAP_LINEAR;
+}
+
+inline TextureFilter GetDefaultMagFilter(size_t n_level) {
+    return (n_level == 1) ? TextureFilter::NEAREST : TextureFilter::LINEAR;
+}
+
+// Apply filters to the texture if any, after checking them
+void SetTextureFilter(GLenum target, GLuint tex_id, TextureFilter min_filter,
+                      TextureFilter mag_filter) {
+    if (mag_filter != TextureFilter::NEAREST &&
+        mag_filter != TextureFilter::LINEAR) {
+        throw std::runtime_error("Mipmap filter is for minification");
+    }
+    if (tex_id == 0) {
+        return;
+    }
+    OGLW_CHECK(glBindTexture, target, tex_id);
+    OGLW_CHECK(glTexParameteri, target, GL_TEXTURE_MIN_FILTER,
+               GetGlFilter(min_filter));
+    OGLW_CHECK(glTexParameteri, target, GL_TEXTURE_MAG_FILTER,
+               GetGlFilter(mag_filter));
+}
+
+// Clamp the level range into `n_level` levels, and apply it to the texture
+void SetTextureLevelRange(GLenum target, GLuint tex_id, size_t n_level,
+                          size_t& base_level, size_t& max_level) {
+    max_level = std::min(max_level, n_level - 1);
+    base_level = std::min(base_level, max_level);
+    OGLW_CHECK(glBindTexture, target, tex_id);
+    OGLW_CHECK(glTexParameteri, target, GL_TEXTURE_BASE_LEVEL,
+               static_cast<GLint>(base_level));
+    OGLW_CHECK(glTexParameteri, target, GL_TEXTURE_MAX_LEVEL,
+               static_cast<GLint>(max_level));
+}
 
+// Upload `w` x `h` pixels in rows of `row_len` pixels to (x, y) of layer `z`
+// (0 for 2D). `pixels` is the offset if an unpack buffer is bound.
 template <typename T>
-class GpuImage<T>::Impl {
-public:
-    Impl() {}
-    Impl(size_t w, size_t h, size_t d) {
-        init(w, h, d);
+void UploadTexture(GLenum target, GLuint tex_id, size_t level, size_t x,
+                   size_t y, size_t z, size_t w, size_t h, size_t d,
+                   size_t row_len, const void* pixels) {
+    OGLW_CHECK(glBindTexture, target, tex_id);
+    OGLW_CHECK(glPixelStorei, GL_UNPACK_ALIGNMENT, GetGlStoreSize(d));
+    OGLW_CHECK(glPixelStorei, GL_UNPACK_ROW_LENGTH,
+               static_cast<GLint>(row_len));
+    if (target == GL_TEXTURE_2D) {
+        OGLW_CHECK(glTexSubImage2D, target, static_cast<GLint>(level), x, y,
+                   w, h, GetGlFmt(d), GetGlType<T>(), pixels);
+    } else {
+        OGLW_CHECK(glTexSubImage3D, target, static_cast<GLint>(level), x, y,
+                   z, w, h, 1, GetGlFmt(d), GetGlType<T>(), pixels);
     }
+    OGLW_CHECK(glPixelStorei, GL_UNPACK_ROW_LENGTH, 0);
+}
 
-    Impl(const Impl& lhs) {
-        init(lhs.m_w, lhs.m_h, lhs.m_d);
-        CopyTexture(lhs.m_tex_id, m_tex_id, lhs.m_w, lhs.m_h, lhs.m_d);
+// Delete the texture and its framebuffer, returning whether it had a texture
+bool ReleaseTexture(GLuint& tex_id, GLuint& fbo_id) {
+    if (fbo_id != 0) {
+        glDeleteFramebuffers(1, &fbo_id);
+        fbo_id = 0;
     }
+    if (tex_id == 0) {
+        return false;
+    }
+    glDeleteTextures(1, &tex_id);
+    tex_id = 0;
+    return true;
+}
 
-    Impl(Impl&&) = delete;
+// -----------------------------------------------------------------------------
+// Number of pack buffers of each image, which readbacks use in turn
+constexpr size_t READBACK_RING_SIZE = 3;
+// Timeout of each wait for a fence (ns), which is repeated until signaled
+constexpr GLuint64 FENCE_WAIT_NS = 1000000000;
+// Alignment of upload slots (bytes), enough for any
+// GL_MIN_MAP_BUFFER_ALIGNMENT and SIMD stores
+constexpr size_t UPLOAD_SLOT_ALIGN = 256;
+// Uploads smaller than this are staged in the calling thread
+constexpr size_t UPLOAD_INLINE_BYTES = 256 * 1024;
 
-    Impl& operator=(const Impl& lhs) {
-        if (!IsSameSize(*this, lhs)) {
-            init(lhs.m_w, lhs.m_h, lhs.m_d);
+// Wait for the fence and delete it
+void WaitFence(GLsync& fence) {
+    while (true) {
+        const GLenum ret = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                            FENCE_WAIT_NS);
+        if (ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED) {
+            break;
+        } else if (ret == GL_WAIT_FAILED) {
+            throw std::runtime_error("Failed to wait for fence");
         }
-        CopyTexture(lhs.m_tex_id, m_tex_id, lhs.m_w, lhs.m_h, lhs.m_d);
-        return *this;
     }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
 
-    Impl& operator=(Impl&&) = delete;
+bool HasBufferStorage() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (4 < major || (major == 4 && 4 <= minor)) {
+        return true;
+    }
+    GLint n_ext = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &n_ext);
+    for (GLint i = 0; i < n_ext; i++) {
+        const GLubyte* ext =
+                glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        if (ext && std::strcmp(reinterpret_cast<const char*>(ext),
+                               "GL_ARB_buffer_storage") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    ~Impl() {
+// -----------------------------------------------------------------------------
+// Pixel pack buffer, which grows to the largest readback
+struct PackBuffer {
+    PackBuffer() = default;
+    PackBuffer(const PackBuffer&) = delete;
+    PackBuffer& operator=(const PackBuffer&) = delete;
+    ~PackBuffer() {
+        if (pbo_id != 0) {
+            glDeleteBuffers(1, &pbo_id);
+        }
+    }
+
+    GLuint pbo_id = 0;
+    size_t capacity = 0;  // Bytes
+};
+
+// -----------------------------------------------------------------------------
+// Stack of same-sized 2D images in `GL_TEXTURE_2D_ARRAY` or `GL_TEXTURE_3D`,
+// whose layers are halved in mip levels only for 3D
+template <typename T>
+class LayeredTexture {
+public:
+    explicit LayeredTexture(GLenum target) : m_target(target) {}
+    LayeredTexture(const LayeredTexture&) = delete;
+    LayeredTexture& operator=(const LayeredTexture& lhs) {
+        if (!isSameSize(lhs) || m_n_level != lhs.m_n_level) {
+            init(lhs.m_w, lhs.m_h, lhs.m_d, lhs.m_n_layer, lhs.m_n_level);
+        }
+        CopyTextureLevels(m_target, lhs.m_tex_id, m_tex_id, m_w, m_h,
+                          m_n_layer, m_n_level);
+        if (!empty()) {
+            setFilter(lhs.m_min_filter, lhs.m_mag_filter);
+            setLevelRange(lhs.m_base_level, lhs.m_max_level);
+        }
+        return *this;
+    }
+
+    ~LayeredTexture() {
         release();
     }
 
     // -------------------------------------------------------------------------
-    CpuImagePtr<T> toCpu() const {
-        // Copy GPU -> CPU
-        // Cost of allocation is almost zero because of FastArray.
+    CpuImagePtr<T> toCpu(size_t layer, size_t level) const {
         if (empty()) {
             return {};
         }
+        if (m_n_level <= level) {
+            throw std::runtime_error("Out of mip levels to read");
+        }
+        if (getLayerCount(level) <= layer) {
+            throw std::runtime_error("Out of layers to read");
+        }
+        const size_t w = GetMipSize(m_w, level);
+        const size_t h = GetMipSize(m_h, level);
 
-        GLuint fbo_id;
-        OGLW_CHECK(glGenFramebuffers, 1, &fbo_id);
-        OGLW_CHECK(glBindFramebuffer, GL_FRAMEBUFFER, fbo_id);
-        OGLW_CHECK(glFramebufferTexture2D, GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                   GL_TEXTURE_2D, m_tex_id, 0);
-
-        auto cpu_img = CpuImage<T>::Create(m_w, m_h, m_d);
+        auto cpu_img = CpuImage<T>::Create(w, h, m_d);
 
+        // The layer is attached to a framebuffer kept for readbacks
+        if (m_fbo_id == 0) {
+            OGLW_CHECK(glGenFramebuffers, 1, &m_fbo_id);
+        }
+        OGLW_CHECK(glBindFramebuffer, GL_READ_FRAMEBUFFER, m_fbo_id);
+        OGLW_CHECK(glFramebufferTextureLayer, GL_READ_FRAMEBUFFER,
+                   GL_COLOR_ATTACHMENT0, m_tex_id, static_cast<GLint>(level),
+                   static_cast<GLint>(layer));
         OGLW_CHECK(glPixelStorei, GL_PACK_ALIGNMENT, GetGlStoreSize(m_d));
-        OGLW_CHECK(glReadPixels, 0, 0, m_w, m_h, GetGlFmt(m_d), GetGlType<T>(),
+        OGLW_CHECK(glReadPixels, 0, 0, w, h, GetGlFmt(m_d), GetGlType<T>(),
                    cpu_img->data());
-        OGLW_CHECK(glBindFramebuffer, GL_FRAMEBUFFER, 0);
-        OGLW_CHECK(glDeleteFramebuffers, 1, &fbo_id);
+        OGLW_CHECK(glBindFramebuffer, GL_READ_FRAMEBUFFER, 0);
 
         return cpu_img;
     }
 
-    void fromCpu(const CpuImagePtr<T>& cpu_img) {
-        fromCpu(*cpu_img);
+    void fromCpu(size_t layer, const CpuImage<T>& cpu_img) {
+        if (m_w != cpu_img.getWidth() || m_h != cpu_img.getHeight() ||
+            m_d != cpu_img.getDepth()) {
+            throw std::runtime_error("Invalid image size for the layer");
+        }
+        checkLayer(layer);
+        if (cpu_img.getLayout() == ImageLayout::PLANAR) {
+            // Textures are interleaved
+            CpuImage<T> interleaved = cpu_img;
+            interleaved.setLayout(ImageLayout::INTERLEAVED);
+            upload(layer, interleaved.view(), 0, 0);
+            return;
+        }
+        upload(layer, cpu_img.view(), 0, 0);
     }
 
-    void fromCpu(const CpuImage<T>& cpu_img) {
-        // Copy CPU -> GPU
-        if (!IsSameSize(*this, cpu_img)) {
-            init(cpu_img.getWidth(), cpu_img.getHeight(), cpu_img.getDepth());
+    void fromCpu(size_t layer, const CpuImageView<const T>& cpu_view,
+                 size_t x, size_t y) {
+        if (m_w < x + cpu_view.getWidth() || m_h < y + cpu_view.getHeight() ||
+            m_d != cpu_view.getDepth()) {
+            throw std::runtime_error("Out of texture range to update");
         }
-        OGLW_CHECK(glPixelStorei, GL_UNPACK_ALIGNMENT, GetGlStoreSize(m_d));
-        OGLW_CHECK(glTexSubImage2D, GL_TEXTURE_2D, 0, 0, 0, m_w, m_h,
-                   GetGlFmt(m_d), GetGlType<T>(), cpu_img.data());
+        checkLayer(layer);
+        upload(layer, cpu_view, x, y);
+    }
+
+    void fromCpu(const std::vector<CpuImagePtr<T>>& layers) {
+        if (layers.empty() || !layers[0]) {
+            throw std::runtime_error("No layer to upload");
+        }
+        const size_t w = layers[0]->getWidth(), h = layers[0]->getHeight();
+        const size_t d = layers[0]->getDepth();
+        for (size_t layer = 0; layer < layers.size(); layer++) {
+            const auto& img = layers[layer];
+            if (!img || img->getWidth() != w || img->getHeight() != h ||
+                img->getDepth() != d) {
+                std::stringstream ss;
+                ss << "Invalid size of layer " << layer;
+                throw std::runtime_error(ss.str());
+            }
+        }
+        if (m_w != w || m_h != h || m_d != d || m_n_layer != layers.size()) {
+            init(w, h, d, layers.size(), (1 < m_n_level) ? 0 : 1);
+        }
+        for (size_t layer = 0; layer < layers.size(); layer++) {
+            fromCpu(layer, *layers[layer]);
+        }
+    }
+
+    void generateMipmaps() {
+        if (empty() || m_n_level <= 1) {
+            return;
+        }
+        OGLW_CHECK(glBindTexture, m_target, m_tex_id);
+        OGLW_CHECK(glGenerateMipmap, m_target);
     }
 
     // -------------------------------------------------------------------------
-    void init(size_t w, size_t h, size_t d) {
+    void init(size_t w, size_t h, size_t d, size_t n_layer, size_t n_level) {
         // Release forcibly
         release();
 
         m_w = w;
         m_h = h;
         m_d = d;
+        m_n_layer = n_layer;
 
         // Zero size
-        if (w == 0 || h == 0 || d == 0) {
+        if (w == 0 || h == 0 || d == 0 || n_layer == 0) {
             return;
         }
 
         // Create
+        size_t max_level = GetMipLevelCount(w, h);
+        if (m_target == GL_TEXTURE_3D) {
+            max_level = std::max(max_level, GetMipLevelCount(n_layer, 1));
+        }
+        m_n_level = (n_level == 0) ? max_level : std::min(n_level, max_level);
         OGLW_CHECK(glGenTextures, 1, &m_tex_id);
-        OGLW_CHECK(glBindTexture, GL_TEXTURE_2D, m_tex_id);
-        OGLW_CHECK(glTexStorage2D, GL_TEXTURE_2D, 1, GetGlInternalFmt<T>(d), w,
-                   h);
-        OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                   GL_NEAREST);
-        OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                   GL_NEAREST);
-        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-        //            GL_LINEAR);
-        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-        //            GL_LINEAR);
-        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-        //            GL_CLAMP);
-        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-        //            GL_CLAMP);
+        OGLW_CHECK(glBindTexture, m_target, m_tex_id);
+        OGLW_CHECK(glTexStorage3D, m_target, static_cast<GLsizei>(m_n_level),
+                   GetGlInternalFmt<T>(d), w, h, n_layer);
+        setFilter(GetDefaultMinFilter(m_n_level),
+                  GetDefaultMagFilter(m_n_level));
+        setLevelRange(0, m_n_level - 1);
     }
 
     bool empty() const {
-        return (m_tex_id == 0);
+        return m_tex_id == 0;
     }
 
     size_t getWidth() const {
@@ -237,6 +477,31 @@ public:
         return m_d;
     }
 
+    size_t getLayerCount(size_t level = 0) const {
+        return GetLayerCount(m_target, m_n_layer, level);
+    }
+
+    size_t getLevelCount() const {
+        return m_n_level;
+    }
+
+    // -------------------------------------------------------------------------
+    void setFilter(TextureFilter min_filter, TextureFilter mag_filter) {
+        SetTextureFilter(m_target, m_tex_id, min_filter, mag_filter);
+        m_min_filter = min_filter;
+        m_mag_filter = mag_filter;
+    }
+
+    void setLevelRange(size_t base_level, size_t max_level) {
+        if (empty()) {
+            return;
+        }
+        m_base_level = base_level;
+        m_max_level = max_level;
+        SetTextureLevelRange(m_target, m_tex_id, m_n_level, m_base_level,
+                             m_max_level);
+    }
+
     // -------------------------------------------------------------------------
     int getTextureId() const {
         return static_cast<int>(m_tex_id);
@@ -244,97 +509,1087 @@ public:
 
     // -------------------------------------------------------------------------
 private:
+    bool isSameSize(const LayeredTexture& lhs) const {
+        return m_w == lhs.m_w && m_h == lhs.m_h && m_d == lhs.m_d &&
+               m_n_layer == lhs.m_n_layer;
+    }
+
+    void checkLayer(size_t layer) const {
+        if (m_n_layer <= layer) {
+            throw std::runtime_error("Out of layers to update");
+        }
+    }
+
+    void upload(size_t layer, const CpuImageView<const T>& cpu_view,
+                size_t x, size_t y) {
+        if (empty() || cpu_view.empty()) {
+            return;
+        }
+        // Rows of the parent image (may be padded)
+        UploadTexture<T>(m_target, m_tex_id, 0, x, y, layer,
+                         cpu_view.getWidth(), cpu_view.getHeight(), m_d,
+                         cpu_view.getRowStride() / m_d, cpu_view.data());
+    }
+
     void release() {
-        if (!empty()) {
-            glDeleteTextures(1, &m_tex_id);
-            m_tex_id = 0;
+        if (ReleaseTexture(m_tex_id, m_fbo_id)) {
             m_w = 0;
             m_h = 0;
             m_d = 0;
+            m_n_layer = 0;
+            m_n_level = 1;
         }
     }
 
+    const GLenum m_target;
     size_t m_w = 0, m_h = 0, m_d = 0;
+    size_t m_n_layer = 0;
+    size_t m_n_level = 1;
+    TextureFilter m_min_filter = TextureFilter::NEAREST;
+    TextureFilter m_mag_filter = TextureFilter::NEAREST;
+    size_t m_base_level = 0, m_max_level = 0;
     GLuint m_tex_id = 0;
+    mutable GLuint m_fbo_id = 0;
 };
 
 // -----------------------------------------------------------------------------
-// ------------------------------- Pimpl Pattern -------------------------------
-// -----------------------------------------------------------------------------
-template <typename T>
-GpuImage<T>::GpuImage() : m_impl(std::make_unique<Impl>()) {}
 
-template <typename T>
-GpuImage<T>::GpuImage(size_t w, size_t h, size_t d)
-    : m_impl(std::make_unique<Impl>(w, h, d)) {}
+}  // namespace
 
+// ================================ GPU Readback ===============================
 template <typename T>
-GpuImage<T>::GpuImage(const GpuImage& lhs)
-    : m_impl(std::make_unique<Impl>(*lhs.m_impl)) {}
+class GpuReadback<T>::Impl {
+public:
+    Impl(const std::shared_ptr<PackBuffer>& buffer, size_t w, size_t h,
+         size_t d)
+        : m_buffer(buffer), m_w(w), m_h(h), m_d(d) {}
 
-template <typename T>
-GpuImage<T>::GpuImage(GpuImage&&) = default;
+    Impl(const Impl&) = delete;
+    Impl& operator=(const Impl&) = delete;
 
-template <typename T>
-GpuImage<T>& GpuImage<T>::operator=(const GpuImage& lhs) {
-    *m_impl = *lhs.m_impl;
-    return *this;
-}
+    ~Impl() {
+        if (m_fence) {
+            glDeleteSync(m_fence);
+        }
+    }
 
-template <typename T>
-GpuImage<T>& GpuImage<T>::operator=(GpuImage&&) = default;
+    // -------------------------------------------------------------------------
+    // Copy from the bound read framebuffer
+    void start() {
+        PackBuffer& buffer = *m_buffer;
+        const size_t n_bytes = m_w * m_h * m_d * sizeof(T);
+        if (buffer.pbo_id == 0) {
+            OGLW_CHECK(glGenBuffers, 1, &buffer.pbo_id);
+        }
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_PACK_BUFFER, buffer.pbo_id);
+        if (buffer.capacity < n_bytes) {
+            OGLW_CHECK(glBufferData, GL_PIXEL_PACK_BUFFER,
+                       static_cast<GLsizeiptr>(n_bytes), nullptr,
+                       GL_STREAM_READ);
+            buffer.capacity = n_bytes;
+        }
+        // Rows are packed densely as CPU images
+        OGLW_CHECK(glPixelStorei, GL_PACK_ALIGNMENT, GetGlStoreSize(m_d));
+        OGLW_CHECK(glReadPixels, 0, 0, m_w, m_h, GetGlFmt(m_d), GetGlType<T>(),
+                   nullptr);
+        m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_PACK_BUFFER, 0);
+        // Submit, so that the fence is signaled without waiting for it
+        glFlush();
+    }
 
-template <typename T>
-GpuImage<T>::~GpuImage() = default;
+    bool ready() const {
+        if (!m_fence) {
+            return true;
+        }
+        GLint status = GL_UNSIGNALED;
+        OGLW_CHECK(glGetSynciv, m_fence, GL_SYNC_STATUS, 1, nullptr, &status);
+        return status == GL_SIGNALED;
+    }
 
-// -----------------------------------------------------------------------------
-template <typename T>
-CpuImagePtr<T> GpuImage<T>::toCpu() const {
-    return m_impl->toCpu();
-}
+    CpuImagePtr<T> get() {
+        if (!m_buffer) {
+            return m_result;
+        }
+        WaitFence(m_fence);
 
-template <typename T>
-void GpuImage<T>::fromCpu(const CpuImagePtr<T>& cpu_img) {
-    m_impl->fromCpu(cpu_img);
-}
+        const size_t n_bytes = m_w * m_h * m_d * sizeof(T);
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_PACK_BUFFER, m_buffer->pbo_id);
+        const void* src = glMapBufferRange(
+                GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(n_bytes),
+                GL_MAP_READ_BIT);
+        if (!src) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            throw std::runtime_error("Failed to map pack buffer");
+        }
+        auto cpu_img = CpuImage<T>::Create(m_w, m_h, m_d);
+        std::memcpy(cpu_img->data(), src, n_bytes);
+        OGLW_CHECK(glUnmapBuffer, GL_PIXEL_PACK_BUFFER);
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_PACK_BUFFER, 0);
 
-template <typename T>
-void GpuImage<T>::fromCpu(const CpuImage<T>& cpu_img) {
-    m_impl->fromCpu(cpu_img);
-}
+        // Return the buffer to the ring
+        m_buffer.reset();
+        m_result = cpu_img;
+        return m_result;
+    }
 
-// -----------------------------------------------------------------------------
-template <typename T>
-void GpuImage<T>::init(size_t w, size_t h, size_t d) {
-    m_impl->init(w, h, d);
-}
+private:
+    std::shared_ptr<PackBuffer> m_buffer;  // Until resolved
+    size_t m_w, m_h, m_d;
+    GLsync m_fence = nullptr;
+    CpuImagePtr<T> m_result;
+};
 
+// ============================== GPU Upload Ring ==============================
 template <typename T>
-bool GpuImage<T>::empty() const {
-    return m_impl->empty();
-}
+class GpuUploadRing<T>::Impl {
+public:
+    Impl(size_t slot_bytes, size_t n_slot) {
+        if (slot_bytes == 0 || n_slot == 0) {
+            throw std::runtime_error("Empty upload ring");
+        }
+        if (!HasBufferStorage()) {
+            throw std::runtime_error("Upload ring requires OpenGL 4.4");
+        }
+        m_slot_bytes = (slot_bytes + UPLOAD_SLOT_ALIGN - 1) /
+                       UPLOAD_SLOT_ALIGN * UPLOAD_SLOT_ALIGN;
+        m_slots.resize(n_slot);
 
-template <typename T>
-size_t GpuImage<T>::getWidth() const {
-    return m_impl->getWidth();
-}
+        // Written by CPU while GPU reads other slots
+        const GLsizeiptr n_bytes =
+                static_cast<GLsizeiptr>(m_slot_bytes * n_slot);
+        const GLbitfield flags =
+                GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        OGLW_CHECK(glGenBuffers, 1, &m_pbo_id);
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, m_pbo_id);
+        OGLW_CHECK(glBufferStorage, GL_PIXEL_UNPACK_BUFFER, n_bytes, nullptr,
+                   flags);
+        m_data = static_cast<uint8_t*>(
+                glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, n_bytes, flags));
+        OGLW_CHECK(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!m_data) {
+            glDeleteBuffers(1, &m_pbo_id);
+            throw std::runtime_error("Failed to map upload ring");
+        }
+    }
 
-template <typename T>
-size_t GpuImage<T>::getHeight() const {
-    return m_impl->getHeight();
-}
+    ~Impl() {
+        for (auto&& slot : m_slots) {
+            if (slot.fence) {
+                glDeleteSync(slot.fence);
+            }
+        }
+        // Unmapped with the deletion
+        glDeleteBuffers(1, &m_pbo_id);
+    }
 
-template <typename T>
-size_t GpuImage<T>::getDepth() const {
-    return m_impl->getDepth();
-}
+    // -------------------------------------------------------------------------
+    CpuImageView<T> acquire(size_t w, size_t h, size_t d) {
+        if (m_slot_bytes < w * h * d * sizeof(T)) {
+            throw std::runtime_error("Too large image for upload slot");
+        }
+        Slot& slot = m_slots[m_next_idx];
+        if (slot.acquired) {
+            throw std::runtime_error("All upload slots are acquired");
+        }
+        if (slot.fence) {
+            WaitFence(slot.fence);
+        }
+        slot.acquired = true;
+        T* data = reinterpret_cast<T*>(m_data + m_next_idx * m_slot_bytes);
+        m_next_idx = (m_next_idx + 1) % m_slots.size();
+        return {nullptr, data, w, h, d, w * d};
+    }
+
+    void commit(const CpuImageView<const T>& slot_view, GpuImage<T>& gpu_img,
+                size_t x, size_t y, size_t level) {
+        // Find the slot from the address
+        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(slot_view.data());
+        const size_t offset = (m_data <= ptr)
+                                      ? static_cast<size_t>(ptr - m_data)
+                                      : ~size_t(0);
+        const size_t idx = offset / m_slot_bytes;
+        if (m_slots.size() <= idx || !m_slots[idx].acquired) {
+            throw std::runtime_error("Not an acquired upload slot");
+        }
+        const size_t w = slot_view.getWidth(), h = slot_view.getHeight();
+        const size_t d = slot_view.getDepth();
+        if (gpu_img.getLevelCount() <= level ||
+            GetMipSize(gpu_img.getWidth(), level) < x + w ||
+            GetMipSize(gpu_img.getHeight(), level) < y + h ||
+            gpu_img.getDepth() != d) {
+            throw std::runtime_error("Out of texture range to update");
+        }
+
+        if (!slot_view.empty() && !gpu_img.empty()) {
+            const GLuint tex_id = static_cast<GLuint>(gpu_img.getTextureId());
+            OGLW_CHECK(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, m_pbo_id);
+            // Pointer is the offset in the bound buffer
+            UploadTexture<T>(GL_TEXTURE_2D, tex_id, level, x, y, 0, w, h, d,
+                             slot_view.getRowStride() / d,
+                             reinterpret_cast<const void*>(offset));
+            OGLW_CHECK(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        // Reusable after the GPU has read it
+        Slot& slot = m_slots[idx];
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.acquired = false;
+    }
+
+    void upload(const CpuImageView<const T>& cpu_view, GpuImage<T>& gpu_img,
+                size_t x, size_t y, size_t level) {
+        const size_t w = cpu_view.getWidth(), h = cpu_view.getHeight();
+        const size_t d = cpu_view.getDepth();
+        CpuImageView<T> slot_view = acquire(w, h, d);
+        const size_t row_bytes = w * d * sizeof(T);
+        const size_t n_worker =
+                (row_bytes * h < UPLOAD_INLINE_BYTES) ? 1 : 0;
+        ParallelFor(h,
+                    [&](size_t y_begin, size_t y_end) {
+                        for (size_t sy = y_begin; sy < y_end; sy++) {
+                            std::memcpy(slot_view.data() + sy * w * d,
+                                        cpu_view.data() +
+                                                sy * cpu_view.getRowStride(),
+                                        row_bytes);
+                        }
+                    },
+                    n_worker);
+        commit(slot_view, gpu_img, x, y, level);
+    }
+
+    template <typename U>
+    void upload(const CpuImageView<const U>& cpu_view, GpuImage<T>& gpu_img,
+                size_t x, size_t y, size_t level, float scale, float bias) {
+        const size_t w = cpu_view.getWidth(), h = cpu_view.getHeight();
+        const size_t d = cpu_view.getDepth();
+        CpuImageView<T> slot_view = acquire(w, h, d);
+        const size_t row_size = w * d;
+        const size_t n_worker =
+                (row_size * sizeof(T) * h < UPLOAD_INLINE_BYTES) ? 1 : 0;
+        ParallelFor(h,
+                    [&](size_t y_begin, size_t y_end) {
+                        for (size_t sy = y_begin; sy < y_end; sy++) {
+                            ConvertRow(cpu_view.data() +
+                                               sy * cpu_view.getRowStride(),
+                                       slot_view.data() + sy * row_size,
+                                       row_size, scale, bias);
+                        }
+                    },
+                    n_worker);
+        commit(slot_view, gpu_img, x, y, level);
+    }
+
+    size_t getSlotBytes() const {
+        return m_slot_bytes;
+    }
+
+    size_t getSlotCount() const {
+        return m_slots.size();
+    }
+
+private:
+    struct Slot {
+        bool acquired = false;
+        GLsync fence = nullptr;  // Of the last commit
+    };
+
+    size_t m_slot_bytes = 0;
+    std::vector<Slot> m_slots;
+    size_t m_next_idx = 0;
+    GLuint m_pbo_id = 0;
+    uint8_t* m_data = nullptr;  // Mapped persistently
+};
+
+// ================================= GPU Image =================================
 
-// -----------------------------------------------------------------------------
 template <typename T>
-int GpuImage<T>::getTextureId() const {
-    return m_impl->getTextureId();
-}
+class GpuImage<T>::Impl {
+public:
+    Impl() {}
+    Impl(size_t w, size_t h, size_t d, size_t n_level = 1) {
+        init(w, h, d, n_level);
+    }
+
+    Impl(const Impl& lhs) {
+        *this = lhs;
+    }
+
+    Impl(Impl&&) = delete;
+
+    Impl& operator=(const Impl& lhs) {
+        if (!IsSameSize(*this, lhs) || m_n_level != lhs.m_n_level) {
+            init(lhs.m_w, lhs.m_h, lhs.m_d, lhs.m_n_level);
+        }
+        CopyTextureLevels(GL_TEXTURE_2D, lhs.m_tex_id, m_tex_id, m_w, m_h, 1,
+                          m_n_level);
+        if (!empty()) {
+            setFilter(lhs.m_min_filter, lhs.m_mag_filter);
+            setLevelRange(lhs.m_base_level, lhs.m_max_level);
+        }
+        m_sync_id = lhs.m_sync_id;
+        return *this;
+    }
+
+    Impl& operator=(Impl&&) = delete;
+
+    ~Impl() {
+        release();
+    }
 
+    // -------------------------------------------------------------------------
+    CpuImagePtr<T> toCpu(size_t level) const {
+        // Copy GPU -> CPU
+        // Cost of allocation is almost zero because of FastArray.
+        if (empty()) {
+            return {};
+        }
+        if (m_n_level <= level) {
+            throw std::runtime_error("Out of mip levels to read");
+        }
+        const size_t w = GetMipSize(m_w, level);
+        const size_t h = GetMipSize(m_h, level);
+
+        auto cpu_img = CpuImage<T>::Create(w, h, m_d);
+
+        bindReadFramebuffer(level);
+        OGLW_CHECK(glPixelStorei, GL_PACK_ALIGNMENT, GetGlStoreSize(m_d));
+        OGLW_CHECK(glReadPixels, 0, 0, w, h, GetGlFmt(m_d), GetGlType<T>(),
+                   cpu_img->data());
+        OGLW_CHECK(glBindFramebuffer, GL_READ_FRAMEBUFFER, 0);
+
+        return cpu_img;
+    }
+
+    GpuReadback<T> toCpuAsync(size_t level) const {
+        if (empty()) {
+            return {};
+        }
+        if (m_n_level <= level) {
+            throw std::runtime_error("Out of mip levels to read");
+        }
+        // Take the next buffer, whose last readback must finish first
+        if (m_pack_buffers.empty()) {
+            m_pack_buffers.resize(READBACK_RING_SIZE);
+            m_pack_users.resize(READBACK_RING_SIZE);
+        }
+        const size_t idx = m_pack_idx;
+        m_pack_idx = (m_pack_idx + 1) % READBACK_RING_SIZE;
+        if (auto user = m_pack_users[idx].lock()) {
+            user->get();
+        }
+        if (!m_pack_buffers[idx]) {
+            m_pack_buffers[idx] = std::make_shared<PackBuffer>();
+        }
+
+        using ReadbackImpl = typename GpuReadback<T>::Impl;
+        auto readback = std::make_shared<ReadbackImpl>(
+                m_pack_buffers[idx], GetMipSize(m_w, level),
+                GetMipSize(m_h, level), m_d);
+        bindReadFramebuffer(level);
+        readback->start();
+        OGLW_CHECK(glBindFramebuffer, GL_READ_FRAMEBUFFER, 0);
+        m_pack_users[idx] = readback;
+        return GpuReadback<T>(readback);
+    }
+
+    void fromCpu(const CpuImagePtr<T>& cpu_img) {
+        fromCpu(*cpu_img);
+    }
+
+    void fromCpu(CpuImage<T>& cpu_img) {
+        if (!IsSameSize(*this, cpu_img)) {
+            init(cpu_img.getWidth(), cpu_img.getHeight(), cpu_img.getDepth(),
+                 (1 < m_n_level) ? 0 : 1);
+        }
+        if (m_sync_id != 0 && m_sync_id == cpu_img.getSyncId()) {
+            // The rest is same as the last upload
+            uploadRects(cpu_img, cpu_img.getDirtyRects());
+        } else {
+            uploadImage(cpu_img, 0);
+        }
+        m_sync_id = cpu_img.markSynced();
+    }
+
+    void fromCpu(const CpuImage<T>& cpu_img) {
+        // Whole upload, since the image's tracking state can not be updated
+        if (!IsSameSize(*this, cpu_img)) {
+            init(cpu_img.getWidth(), cpu_img.getHeight(), cpu_img.getDepth(),
+                 (1 < m_n_level) ? 0 : 1);
+        }
+        uploadImage(cpu_img, 0);
+        m_sync_id = 0;
+    }
+
+    void fromCpu(const CpuImageView<const T>& cpu_view) {
+        // Copy CPU -> GPU
+        if (!IsSameSize(*this, cpu_view)) {
+            init(cpu_view.getWidth(), cpu_view.getHeight(),
+                 cpu_view.getDepth(), (1 < m_n_level) ? 0 : 1);
+        }
+        upload(cpu_view, 0, 0, 0);
+        m_sync_id = 0;
+    }
+
+    void fromCpu(const CpuImageView<const T>& cpu_view, size_t x, size_t y) {
+        // Copy CPU -> GPU partially
+        if (m_w < x + cpu_view.getWidth() || m_h < y + cpu_view.getHeight() ||
+            m_d != cpu_view.getDepth()) {
+            throw std::runtime_error("Out of texture range to update");
+        }
+        upload(cpu_view, x, y, 0);
+        m_sync_id = 0;
+    }
+
+    void fromCpu(const std::vector<CpuImagePtr<T>>& levels) {
+        if (levels.empty() || !levels[0]) {
+            throw std::runtime_error("No mip level to upload");
+        }
+        const size_t w = levels[0]->getWidth(), h = levels[0]->getHeight();
+        const size_t d = levels[0]->getDepth();
+        for (size_t level = 0; level < levels.size(); level++) {
+            const auto& img = levels[level];
+            if (!img || img->getWidth() != GetMipSize(w, level) ||
+                img->getHeight() != GetMipSize(h, level) ||
+                img->getDepth() != d) {
+                std::stringstream ss;
+                ss << "Invalid size of mip level " << level;
+                throw std::runtime_error(ss.str());
+            }
+        }
+        if (levels.size() > GetMipLevelCount(w, h)) {
+            throw std::runtime_error("Too many mip levels");
+        }
+        if (m_w != w || m_h != h || m_d != d ||
+            m_n_level != levels.size()) {
+            init(w, h, d, levels.size());
+        }
+        for (size_t level = 0; level < levels.size(); level++) {
+            uploadImage(*levels[level], level);
+        }
+        m_sync_id = 0;
+    }
+
+    void generateMipmaps() {
+        if (empty() || m_n_level <= 1) {
+            return;
+        }
+        OGLW_CHECK(glBindTexture, GL_TEXTURE_2D, m_tex_id);
+        OGLW_CHECK(glGenerateMipmap, GL_TEXTURE_2D);
+    }
+
+    // -------------------------------------------------------------------------
+    void init(size_t w, size_t h, size_t d, size_t n_level) {
+        // Release forcibly
+        release();
+
+        m_w = w;
+        m_h = h;
+        m_d = d;
+        m_sync_id = 0;
+
+        // Zero size
+        if (w == 0 || h == 0 || d == 0) {
+            return;
+        }
+
+        // Create
+        const size_t max_level = GetMipLevelCount(w, h);
+        m_n_level = (n_level == 0) ? max_level : std::min(n_level, max_level);
+        OGLW_CHECK(glGenTextures, 1, &m_tex_id);
+        OGLW_CHECK(glBindTexture, GL_TEXTURE_2D, m_tex_id);
+        OGLW_CHECK(glTexStorage2D, GL_TEXTURE_2D,
+                   static_cast<GLsizei>(m_n_level), GetGlInternalFmt<T>(d), w,
+                   h);
+        setFilter(GetDefaultMinFilter(m_n_level),
+                  GetDefaultMagFilter(m_n_level));
+        setLevelRange(0, m_n_level - 1);
+        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+        //            GL_CLAMP);
+        // OGLW_CHECK(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+        //            GL_CLAMP);
+    }
+
+    bool empty() const {
+        return (m_tex_id == 0);
+    }
+
+    size_t getWidth() const {
+        return m_w;
+    }
+
+    size_t getHeight() const {
+        return m_h;
+    }
+
+    size_t getDepth() const {
+        return m_d;
+    }
+
+    size_t getLevelCount() const {
+        return m_n_level;
+    }
+
+    // -------------------------------------------------------------------------
+    void setFilter(TextureFilter min_filter, TextureFilter mag_filter) {
+        SetTextureFilter(GL_TEXTURE_2D, m_tex_id, min_filter, mag_filter);
+        m_min_filter = min_filter;
+        m_mag_filter = mag_filter;
+    }
+
+    void setLevelRange(size_t base_level, size_t max_level) {
+        if (empty()) {
+            return;
+        }
+        m_base_level = base_level;
+        m_max_level = max_level;
+        SetTextureLevelRange(GL_TEXTURE_2D, m_tex_id, m_n_level, m_base_level,
+                             m_max_level);
+    }
+
+    // -------------------------------------------------------------------------
+    int getTextureId() const {
+        return static_cast<int>(m_tex_id);
+    }
+
+    // -------------------------------------------------------------------------
+private:
+    void uploadImage(const CpuImage<T>& cpu_img, size_t level) {
+        if (cpu_img.getLayout() == ImageLayout::PLANAR) {
+            // Textures are interleaved
+            CpuImage<T> interleaved = cpu_img;
+            interleaved.setLayout(ImageLayout::INTERLEAVED);
+            upload(interleaved.view(), 0, 0, level);
+            return;
+        }
+        upload(cpu_img.view(), 0, 0, level);
+    }
+
+    void uploadRects(const CpuImage<T>& cpu_img,
+                     const std::vector<ImageRect>& rects) {
+        if (rects.empty()) {
+            return;
+        }
+        if (cpu_img.getLayout() == ImageLayout::PLANAR) {
+            // Textures are interleaved
+            CpuImage<T> interleaved = cpu_img;
+            interleaved.setLayout(ImageLayout::INTERLEAVED);
+            uploadRects(interleaved, rects);
+            return;
+        }
+        for (auto& rect : rects) {
+            upload(cpu_img.view(rect.x, rect.y, rect.w, rect.h), rect.x,
+                   rect.y, 0);
+        }
+    }
+
+    void upload(const CpuImageView<const T>& cpu_view, size_t x, size_t y,
+                size_t level) {
+        if (empty() || cpu_view.empty()) {
+            return;
+        }
+        // Rows of the parent image (may be padded)
+        UploadTexture<T>(GL_TEXTURE_2D, m_tex_id, level, x, y, 0,
+                         cpu_view.getWidth(), cpu_view.getHeight(), m_d,
+                         cpu_view.getRowStride() / m_d, cpu_view.data());
+    }
+
+    void bindReadFramebuffer(size_t level) const {
+        // Kept for readbacks, and attached each time
+        if (m_fbo_id == 0) {
+            OGLW_CHECK(glGenFramebuffers, 1, &m_fbo_id);
+        }
+        OGLW_CHECK(glBindFramebuffer, GL_READ_FRAMEBUFFER, m_fbo_id);
+        OGLW_CHECK(glFramebufferTexture2D, GL_READ_FRAMEBUFFER,
+                   GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_tex_id,
+                   static_cast<GLint>(level));
+    }
+
+    void release() {
+        if (ReleaseTexture(m_tex_id, m_fbo_id)) {
+            m_w = 0;
+            m_h = 0;
+            m_d = 0;
+            m_n_level = 1;
+        }
+    }
+
+    size_t m_w = 0, m_h = 0, m_d = 0;
+    size_t m_n_level = 1;
+    TextureFilter m_min_filter = TextureFilter::NEAREST;
+    TextureFilter m_mag_filter = TextureFilter::NEAREST;
+    size_t m_base_level = 0, m_max_level = 0;
+    GLuint m_tex_id = 0;
+    mutable GLuint m_fbo_id = 0;
+    // Last uploaded CPU image, whose dirty regions are the difference
+    uint64_t m_sync_id = 0;
+
+    // Ring of pack buffers, and readbacks which may still use them
+    mutable std::vector<std::shared_ptr<PackBuffer>> m_pack_buffers;
+    mutable std::vector<std::weak_ptr<typename GpuReadback<T>::Impl>>
+            m_pack_users;
+    mutable size_t m_pack_idx = 0;
+};
+
+// ========================== GPU Image Array / 3D =============================
+template <typename T>
+class GpuImageArray<T>::Impl : public LayeredTexture<T> {
+public:
+    Impl() : LayeredTexture<T>(GL_TEXTURE_2D_ARRAY) {}
+    Impl& operator=(const Impl&) = default;
+};
+
+template <typename T>
+class GpuImage3D<T>::Impl : public LayeredTexture<T> {
+public:
+    Impl() : LayeredTexture<T>(GL_TEXTURE_3D) {}
+    Impl& operator=(const Impl&) = default;
+};
+
+// -----------------------------------------------------------------------------
+// ------------------------------- Pimpl Pattern -------------------------------
+// -----------------------------------------------------------------------------
+template <typename T>
+GpuReadback<T>::GpuReadback() {}
+
+template <typename T>
+GpuReadback<T>::GpuReadback(const std::shared_ptr<Impl>& impl)
+    : m_impl(impl) {}
+
+template <typename T>
+bool GpuReadback<T>::ready() const {
+    return !m_impl || m_impl->ready();
+}
+
+template <typename T>
+CpuImagePtr<T> GpuReadback<T>::get() {
+    return m_impl ? m_impl->get() : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+GpuUploadRing<T>::GpuUploadRing(size_t slot_bytes, size_t n_slot)
+    : m_impl(std::make_unique<Impl>(slot_bytes, n_slot)) {}
+
+template <typename T>
+GpuUploadRing<T>::~GpuUploadRing() = default;
+
+template <typename T>
+CpuImageView<T> GpuUploadRing<T>::acquire(size_t w, size_t h, size_t d) {
+    return m_impl->acquire(w, h, d);
+}
+
+template <typename T>
+void GpuUploadRing<T>::commit(const CpuImageView<const T>& slot,
+                              GpuImage<T>& gpu_img, size_t x, size_t y,
+                              size_t level) {
+    m_impl->commit(slot, gpu_img, x, y, level);
+}
+
+template <typename T>
+void GpuUploadRing<T>::upload(const CpuImageView<const T>& cpu_view,
+                              GpuImage<T>& gpu_img, size_t x, size_t y,
+                              size_t level) {
+    m_impl->upload(cpu_view, gpu_img, x, y, level);
+}
+
+template <typename T>
+template <typename U>
+void GpuUploadRing<T>::upload(const CpuImageView<const U>& cpu_view,
+                              GpuImage<T>& gpu_img, size_t x, size_t y,
+                              size_t level, float scale, float bias) {
+    m_impl->upload(cpu_view, gpu_img, x, y, level, scale, bias);
+}
+
+template <typename T>
+size_t GpuUploadRing<T>::getSlotBytes() const {
+    return m_impl->getSlotBytes();
+}
+
+template <typename T>
+size_t GpuUploadRing<T>::getSlotCount() const {
+    return m_impl->getSlotCount();
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+GpuImage<T>::GpuImage() : m_impl(std::make_unique<Impl>()) {}
+
+template <typename T>
+GpuImage<T>::GpuImage(size_t w, size_t h, size_t d)
+    : m_impl(std::make_unique<Impl>(w, h, d)) {}
+
+template <typename T>
+GpuImage<T>::GpuImage(size_t w, size_t h, size_t d, size_t n_level)
+    : m_impl(std::make_unique<Impl>(w, h, d, n_level)) {}
+
+template <typename T>
+GpuImage<T>::GpuImage(const GpuImage& lhs)
+    : m_impl(std::make_unique<Impl>(*lhs.m_impl)) {}
+
+template <typename T>
+GpuImage<T>::GpuImage(GpuImage&&) = default;
+
+template <typename T>
+GpuImage<T>& GpuImage<T>::operator=(const GpuImage& lhs) {
+    *m_impl = *lhs.m_impl;
+    return *this;
+}
+
+template <typename T>
+GpuImage<T>& GpuImage<T>::operator=(GpuImage&&) = default;
+
+template <typename T>
+GpuImage<T>::~GpuImage() = default;
+
+// -----------------------------------------------------------------------------
+template <typename T>
+CpuImagePtr<T> GpuImage<T>::toCpu(size_t level) const {
+    return m_impl->toCpu(level);
+}
+
+template <typename T>
+GpuReadback<T> GpuImage<T>::toCpuAsync(size_t level) const {
+    return m_impl->toCpuAsync(level);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(const CpuImagePtr<T>& cpu_img) {
+    m_impl->fromCpu(cpu_img);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(CpuImage<T>& cpu_img) {
+    m_impl->fromCpu(cpu_img);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(const CpuImage<T>& cpu_img) {
+    m_impl->fromCpu(cpu_img);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(const CpuImageView<const T>& cpu_view) {
+    m_impl->fromCpu(cpu_view);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(const CpuImageView<const T>& cpu_view, size_t x,
+                          size_t y) {
+    m_impl->fromCpu(cpu_view, x, y);
+}
+
+template <typename T>
+void GpuImage<T>::fromCpu(const std::vector<CpuImagePtr<T>>& levels) {
+    m_impl->fromCpu(levels);
+}
+
+template <typename T>
+void GpuImage<T>::generateMipmaps() {
+    m_impl->generateMipmaps();
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+void GpuImage<T>::init(size_t w, size_t h, size_t d) {
+    m_impl->init(w, h, d, 1);
+}
+
+template <typename T>
+void GpuImage<T>::init(size_t w, size_t h, size_t d, size_t n_level) {
+    m_impl->init(w, h, d, n_level);
+}
+
+template <typename T>
+bool GpuImage<T>::empty() const {
+    return m_impl->empty();
+}
+
+template <typename T>
+size_t GpuImage<T>::getWidth() const {
+    return m_impl->getWidth();
+}
+
+template <typename T>
+size_t GpuImage<T>::getHeight() const {
+    return m_impl->getHeight();
+}
+
+template <typename T>
+size_t GpuImage<T>::getDepth() const {
+    return m_impl->getDepth();
+}
+
+template <typename T>
+size_t GpuImage<T>::getLevelCount() const {
+    return m_impl->getLevelCount();
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+void GpuImage<T>::setFilter(TextureFilter min_filter,
+                            TextureFilter mag_filter) {
+    m_impl->setFilter(min_filter, mag_filter);
+}
+
+template <typename T>
+void GpuImage<T>::setLevelRange(size_t base_level, size_t max_level) {
+    m_impl->setLevelRange(base_level, max_level);
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+int GpuImage<T>::getTextureId() const {
+    return m_impl->getTextureId();
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+GpuImageArray<T>::GpuImageArray() : m_impl(std::make_unique<Impl>()) {}
+
+template <typename T>
+GpuImageArray<T>::GpuImageArray(size_t w, size_t h, size_t d, size_t n_layer,
+                                size_t n_level)
+    : m_impl(std::make_unique<Impl>()) {
+    m_impl->init(w, h, d, n_layer, n_level);
+}
+
+template <typename T>
+GpuImageArray<T>::GpuImageArray(const GpuImageArray& lhs)
+    : m_impl(std::make_unique<Impl>()) {
+    *m_impl = *lhs.m_impl;
+}
+
+template <typename T>
+GpuImageArray<T>::GpuImageArray(GpuImageArray&&) = default;
+
+template <typename T>
+GpuImageArray<T>& GpuImageArray<T>::operator=(const GpuImageArray& lhs) {
+    *m_impl = *lhs.m_impl;
+    return *this;
+}
+
+template <typename T>
+GpuImageArray<T>& GpuImageArray<T>::operator=(GpuImageArray&&) = default;
+
+template <typename T>
+GpuImageArray<T>::~GpuImageArray() = default;
+
+template <typename T>
+CpuImagePtr<T> GpuImageArray<T>::toCpu(size_t layer, size_t level) const {
+    return m_impl->toCpu(layer, level);
+}
+
+template <typename T>
+void GpuImageArray<T>::fromCpu(size_t layer, const CpuImagePtr<T>& cpu_img) {
+    m_impl->fromCpu(layer, *cpu_img);
+}
+
+template <typename T>
+void GpuImageArray<T>::fromCpu(size_t layer, const CpuImage<T>& cpu_img) {
+    m_impl->fromCpu(layer, cpu_img);
+}
+
+template <typename T>
+void GpuImageArray<T>::fromCpu(size_t layer,
+                                const CpuImageView<const T>& cpu_view,
+                                size_t x, size_t y) {
+    m_impl->fromCpu(layer, cpu_view, x, y);
+}
+
+template <typename T>
+void GpuImageArray<T>::fromCpu(const std::vector<CpuImagePtr<T>>& layers) {
+    m_impl->fromCpu(layers);
+}
+
+template <typename T>
+void GpuImageArray<T>::generateMipmaps() {
+    m_impl->generateMipmaps();
+}
+
+template <typename T>
+void GpuImageArray<T>::init(size_t w, size_t h, size_t d, size_t n_layer,
+                            size_t n_level) {
+    m_impl->init(w, h, d, n_layer, n_level);
+}
+
+template <typename T>
+bool GpuImageArray<T>::empty() const {
+    return m_impl->empty();
+}
+
+template <typename T>
+size_t GpuImageArray<T>::getWidth() const {
+    return m_impl->getWidth();
+}
+
+template <typename T>
+size_t GpuImageArray<T>::getHeight() const {
+    return m_impl->getHeight();
+}
+
+template <typename T>
+size_t GpuImageArray<T>::getDepth() const {
+    return m_impl->getDepth();
+}
+
+template <typename T>
+size_t GpuImageArray<T>::getLayerCount() const {
+    return m_impl->getLayerCount();
+}
+
+template <typename T>
+size_t GpuImageArray<T>::getLevelCount() const {
+    return m_impl->getLevelCount();
+}
+
+template <typename T>
+void GpuImageArray<T>::setFilter(TextureFilter min_filter,
+                                 TextureFilter mag_filter) {
+    m_impl->setFilter(min_filter, mag_filter);
+}
+
+template <typename T>
+void GpuImageArray<T>::setLevelRange(size_t base_level, size_t max_level) {
+    m_impl->setLevelRange(base_level, max_level);
+}
+
+template <typename T>
+int GpuImageArray<T>::getTextureId() const {
+    return m_impl->getTextureId();
+}
+
+// -----------------------------------------------------------------------------
+template <typename T>
+GpuImage3D<T>::GpuImage3D() : m_impl(std::make_unique<Impl>()) {}
+
+template <typename T>
+GpuImage3D<T>::GpuImage3D(size_t w, size_t h, size_t d, size_t n_slice,
+                          size_t n_level)
+    : m_impl(std::make_unique<Impl>()) {
+    m_impl->init(w, h, d, n_slice, n_level);
+}
+
+template <typename T>
+GpuImage3D<T>::GpuImage3D(const GpuImage3D& lhs)
+    : m_impl(std::make_unique<Impl>()) {
+    *m_impl = *lhs.m_impl;
+}
+
+template <typename T>
+GpuImage3D<T>::GpuImage3D(GpuImage3D&&) = default;
+
+template <typename T>
+GpuImage3D<T>& GpuImage3D<T>::operator=(const GpuImage3D& lhs) {
+    *m_impl = *lhs.m_impl;
+    return *this;
+}
+
+template <typename T>
+GpuImage3D<T>& GpuImage3D<T>::operator=(GpuImage3D&&) = default;
+
+template <typename T>
+GpuImage3D<T>::~GpuImage3D() = default;
+
+template <typename T>
+CpuImagePtr<T> GpuImage3D<T>::toCpu(size_t slice, size_t level) const {
+    return m_impl->toCpu(slice, level);
+}
+
+template <typename T>
+void GpuImage3D<T>::fromCpu(size_t slice, const CpuImagePtr<T>& cpu_img) {
+    m_impl->fromCpu(slice, *cpu_img);
+}
+
+template <typename T>
+void GpuImage3D<T>::fromCpu(size_t slice, const CpuImage<T>& cpu_img) {
+    m_impl->fromCpu(slice, cpu_img);
+}
+
+template <typename T>
+void GpuImage3D<T>::fromCpu(size_t slice, const CpuImageView<const T>& cpu_view,
+                            size_t x, size_t y) {
+    m_impl->fromCpu(slice, cpu_view, x, y);
+}
+
+template <typename T>
+void GpuImage3D<T>::fromCpu(const std::vector<CpuImagePtr<T>>& slices) {
+    m_impl->fromCpu(slices);
+}
+
+template <typename T>
+void GpuImage3D<T>::generateMipmaps() {
+    m_impl->generateMipmaps();
+}
+
+template <typename T>
+void GpuImage3D<T>::init(size_t w, size_t h, size_t d, size_t n_slice,
+                         size_t n_level) {
+    m_impl->init(w, h, d, n_slice, n_level);
+}
+
+template <typename T>
+bool GpuImage3D<T>::empty() const {
+    return m_impl->empty();
+}
+
+template <typename T>
+size_t GpuImage3D<T>::getWidth() const {
+    return m_impl->getWidth();
+}
+
+template <typename T>
+size_t GpuImage3D<T>::getHeight() const {
+    return m_impl->getHeight();
+}
+
+template <typename T>
+size_t GpuImage3D<T>::getDepth() const {
+    return m_impl->getDepth();
+}
+
+template <typename T>
+size_t GpuImage3D<T>::getSliceCount() const {
+    return m_impl->getLayerCount();
+}
+
+template <typename T>
+size_t GpuImage3D<T>::getLevelCount() const {
+    return m_impl->getLevelCount();
+}
+
+template <typename T>
+void GpuImage3D<T>::setFilter(TextureFilter min_filter,
+                              TextureFilter mag_filter) {
+    m_impl->setFilter(min_filter, mag_filter);
+}
+
+template <typename T>
+void GpuImage3D<T>::setLevelRange(size_t base_level, size_t max_level) {
+    m_impl->setLevelRange(base_level, max_level);
+}
+
+template <typename T>
+int GpuImage3D<T>::getTextureId() const {
+    return m_impl->getTextureId();
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ Specialization -------------------------------
 // -----------------------------------------------------------------------------
+#define OGLW_INSTANTIATE_UPLOAD(T, U)                                      \
+    template void GpuUploadRing<T>::upload<U>(const CpuImageView<const U>&, \
+                                              GpuImage<T>&, size_t, size_t, \
+                                              size_t, float, float);
+#define OGLW_INSTANTIATE_UPLOAD_ALL(T)   \
+    OGLW_INSTANTIATE_UPLOAD(T, uint8_t)  \
+    OGLW_INSTANTIATE_UPLOAD(T, uint16_t) \
+    OGLW_INSTANTIATE_UPLOAD(T, float)    \
+    OGLW_INSTANTIATE_UPLOAD(T, Float16)
+OGLW_INSTANTIATE_UPLOAD_ALL(uint8_t)
+OGLW_INSTANTIATE_UPLOAD_ALL(uint16_t)
+OGLW_INSTANTIATE_UPLOAD_ALL(float)
+OGLW_INSTANTIATE_UPLOAD_ALL(Float16)
+#undef OGLW_INSTANTIATE_UPLOAD_ALL
+#undef OGLW_INSTANTIATE_UPLOAD
 
 }  // namespace oglw
@@ -1,5 +1,7 @@
 #include <oglw/hair_loader.h>
 
+#include "fast_array.h"
+
 #include <cassert>
 #include <iostream>
 #include <map>
@@ -72,7 +74,7 @@ void ComputeTangents(const std::vector<Strand>& strands,
 
 // -----------------------------------------------------------------------------
 void FlattenStrands(const std::vector<Strand>& strands,
-                    std::vector<float>& vtxs) {
+                    FastArray<float>& vtxs) {
     // Count the number of line segments
     size_t n_seg = 0;
     for (size_t s_idx = 0; s_idx < strands.size(); s_idx++) {
@@ -84,18 +86,13 @@ void FlattenStrands(const std::vector<Strand>& strands,
     }
 
     // Flatten
-    vtxs.resize(n_seg * 2 * 3);
-    size_t seg_idx = 0;
+    vtxs.clear();
+    vtxs.reserve(n_seg * 2 * 3);
     for (size_t s_idx = 0; s_idx < strands.size(); s_idx++) {
         const auto& strand = strands[s_idx];
-        for (size_t v_idx = 0; v_idx < strand.size() - 1; v_idx++) {
-            for (size_t c_idx = 0; c_idx < 3; c_idx++) {
-                vtxs[(seg_idx * 2 + 0) * 3 + c_idx] =
-                    strand[v_idx + 0](static_cast<int>(c_idx));
-                vtxs[(seg_idx * 2 + 1) * 3 + c_idx] =
-                    strand[v_idx + 1](static_cast<int>(c_idx));
-            }
-            seg_idx += 1;
+        for (size_t v_idx = 1; v_idx < strand.size(); v_idx++) {
+            vtxs.append(strand[v_idx - 1].data(), strand[v_idx - 1].data() + 3);
+            vtxs.append(strand[v_idx].data(), strand[v_idx].data() + 3);
         }
     }
 }
@@ -126,7 +123,7 @@ GeometryPtr LoadHair(const std::string& filename, const Vec3& shift) {
     ComputeTangents(strands, strand_tans);
 
     // Flatten
-    std::vector<float> vertices, tangents;
+    FastArray<float> vertices, tangents;
     FlattenStrands(strands, vertices);
     FlattenStrands(strand_tans, tangents);
 
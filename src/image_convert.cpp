@@ -0,0 +1,667 @@
+#include "image_convert.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace oglw {
+
+namespace {
+
+// -----------------------------------------------------------------------------
+float ToFloat(uint8_t v) {
+    return static_cast<float>(v);
+}
+
+float ToFloat(uint16_t v) {
+    return static_cast<float>(v);
+}
+
+float ToFloat(float v) {
+    return v;
+}
+
+float ToFloat(Float16 v) {
+    return static_cast<float>(v);
+}
+
+template <typename T>
+T FromFloat(float v);
+
+template <>
+uint8_t FromFloat(float v) {
+    // NaN goes to 0 as SIMD kernels
+    v = (0.f < v) ? v : 0.f;
+    v = (v < 255.f) ? v : 255.f;
+    return static_cast<uint8_t>(std::lrint(v));
+}
+
+template <>
+uint16_t FromFloat(float v) {
+    v = (0.f < v) ? v : 0.f;
+    v = (v < 65535.f) ? v : 65535.f;
+    return static_cast<uint16_t>(std::lrint(v));
+}
+
+template <>
+float FromFloat(float v) {
+    return v;
+}
+
+template <>
+Float16 FromFloat(float v) {
+    return Float16(v);
+}
+
+template <typename S, typename D>
+void ConvertRowScalar(const S* src, D* dst, size_t n, float scale,
+                      float bias) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = FromFloat<D>(ToFloat(src[i]) * scale + bias);
+    }
+}
+
+bool IsIdentity(float scale, float bias) {
+    return scale == 1.f && bias == 0.f;
+}
+
+// ----------------------------------- SSE2 ------------------------------------
+#if defined(OGLW_SIMD_SSE2)
+size_t ConvertSse2(const uint8_t* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(bias);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i vs[4] = {
+                _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+        for (size_t k = 0; k < 4; k++) {
+            const __m128 f = _mm_cvtepi32_ps(vs[k]);
+            _mm_storeu_ps(dst + i + k * 4, _mm_add_ps(_mm_mul_ps(f, s), b));
+        }
+    }
+    return i;
+}
+
+size_t ConvertSse2(const float* src, uint8_t* dst, size_t n, float scale,
+                   float bias) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(bias);
+    const __m128 lower = _mm_setzero_ps();
+    const __m128 upper = _mm_set1_ps(255.f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i vs[4];
+        for (size_t k = 0; k < 4; k++) {
+            __m128 f = _mm_loadu_ps(src + i + k * 4);
+            f = _mm_add_ps(_mm_mul_ps(f, s), b);
+            // Clamp before the conversion (NaN goes to the lower)
+            f = _mm_min_ps(_mm_max_ps(f, lower), upper);
+            vs[k] = _mm_cvtps_epi32(f);
+        }
+        const __m128i v = _mm_packus_epi16(_mm_packs_epi32(vs[0], vs[1]),
+                                           _mm_packs_epi32(vs[2], vs[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+    return i;
+}
+
+size_t ConvertSse2(const uint16_t* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(bias);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i vs[2] = {_mm_unpacklo_epi16(v, zero),
+                               _mm_unpackhi_epi16(v, zero)};
+        for (size_t k = 0; k < 2; k++) {
+            const __m128 f = _mm_cvtepi32_ps(vs[k]);
+            _mm_storeu_ps(dst + i + k * 4, _mm_add_ps(_mm_mul_ps(f, s), b));
+        }
+    }
+    return i;
+}
+
+size_t ConvertSse2(const float* src, uint16_t* dst, size_t n, float scale,
+                   float bias) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(bias);
+    const __m128 lower = _mm_setzero_ps();
+    const __m128 upper = _mm_set1_ps(65535.f);
+    // SSE2 has only signed packing, so pack with the offset of 32768.
+    const __m128i offset32 = _mm_set1_epi32(32768);
+    const __m128i offset16 = _mm_set1_epi16(-32768);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i vs[2];
+        for (size_t k = 0; k < 2; k++) {
+            __m128 f = _mm_loadu_ps(src + i + k * 4);
+            f = _mm_add_ps(_mm_mul_ps(f, s), b);
+            f = _mm_min_ps(_mm_max_ps(f, lower), upper);
+            vs[k] = _mm_sub_epi32(_mm_cvtps_epi32(f), offset32);
+        }
+        const __m128i v =
+                _mm_xor_si128(_mm_packs_epi32(vs[0], vs[1]), offset16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+    return i;
+}
+
+size_t ConvertSse2(const float* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 f = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(f, s), b));
+    }
+    return i;
+}
+#endif
+
+// ----------------------------------- AVX2 ------------------------------------
+#if defined(OGLW_SIMD_AVX2)
+OGLW_TARGET_AVX2
+size_t ConvertAvx2(const uint8_t* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (size_t k = 0; k < 2; k++) {
+            const __m128i v = _mm_loadl_epi64(
+                    reinterpret_cast<const __m128i*>(src + i + k * 8));
+            const __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+            _mm256_storeu_ps(dst + i + k * 8,
+                             _mm256_add_ps(_mm256_mul_ps(f, s), b));
+        }
+    }
+    return i;
+}
+
+OGLW_TARGET_AVX2
+size_t ConvertAvx2(const float* src, uint8_t* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    const __m256 lower = _mm256_setzero_ps();
+    const __m256 upper = _mm256_set1_ps(255.f);
+    // Packing works in 128-bit lanes, so restore the order at last
+    const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i vs[4];
+        for (size_t k = 0; k < 4; k++) {
+            __m256 f = _mm256_loadu_ps(src + i + k * 8);
+            f = _mm256_add_ps(_mm256_mul_ps(f, s), b);
+            f = _mm256_min_ps(_mm256_max_ps(f, lower), upper);
+            vs[k] = _mm256_cvtps_epi32(f);
+        }
+        __m256i v = _mm256_packus_epi16(_mm256_packs_epi32(vs[0], vs[1]),
+                                        _mm256_packs_epi32(vs[2], vs[3]));
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    return i;
+}
+
+OGLW_TARGET_AVX2
+size_t ConvertAvx2(const uint16_t* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v));
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(f, s), b));
+    }
+    return i;
+}
+
+OGLW_TARGET_AVX2
+size_t ConvertAvx2(const float* src, uint16_t* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    const __m256 lower = _mm256_setzero_ps();
+    const __m256 upper = _mm256_set1_ps(65535.f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i vs[2];
+        for (size_t k = 0; k < 2; k++) {
+            __m256 f = _mm256_loadu_ps(src + i + k * 8);
+            f = _mm256_add_ps(_mm256_mul_ps(f, s), b);
+            f = _mm256_min_ps(_mm256_max_ps(f, lower), upper);
+            vs[k] = _mm256_cvtps_epi32(f);
+        }
+        // Packing works in 128-bit lanes, so restore the order at last
+        __m256i v = _mm256_packus_epi32(vs[0], vs[1]);
+        v = _mm256_permute4x64_epi64(v, 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    return i;
+}
+
+OGLW_TARGET_AVX2
+size_t ConvertAvx2(const float* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 f = _mm256_loadu_ps(src + i);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(f, s), b));
+    }
+    return i;
+}
+
+// ----------------------------------- F16C ------------------------------------
+OGLW_TARGET_F16C
+size_t ConvertF16c(const Float16* src, float* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i h =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m256 f = _mm256_cvtph_ps(h);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(f, s), b));
+    }
+    return i;
+}
+
+OGLW_TARGET_F16C
+size_t ConvertF16c(const float* src, Float16* dst, size_t n, float scale,
+                   float bias) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 f = _mm256_loadu_ps(src + i);
+        f = _mm256_add_ps(_mm256_mul_ps(f, s), b);
+        const __m128i h = _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    return i;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Convert the head with the best kernel, and the rest with the scalar one.
+template <typename S, typename D>
+void ConvertRowSimd(const S* src, D* dst, size_t n, float scale, float bias) {
+    size_t i = 0;
+#if defined(OGLW_SIMD_AVX2)
+    if (UseAvx2()) {
+        i = ConvertAvx2(src, dst, n, scale, bias);
+    } else {
+        i = ConvertSse2(src, dst, n, scale, bias);
+    }
+#elif defined(OGLW_SIMD_SSE2)
+    i = ConvertSse2(src, dst, n, scale, bias);
+#endif
+    ConvertRowScalar(src + i, dst + i, n - i, scale, bias);
+}
+
+template <typename S, typename D>
+void ConvertRowHalf(const S* src, D* dst, size_t n, float scale, float bias) {
+    size_t i = 0;
+#if defined(OGLW_SIMD_AVX2)
+    if (UseF16c()) {
+        i = ConvertF16c(src, dst, n, scale, bias);
+    }
+#endif
+    ConvertRowScalar(src + i, dst + i, n - i, scale, bias);
+}
+
+// Convert through a small float buffer on the stack
+template <typename S, typename D>
+void ConvertRowViaFloat(const S* src, D* dst, size_t n, float scale,
+                        float bias) {
+    constexpr size_t BLOCK_SIZE = 256;
+    float buf[BLOCK_SIZE];
+    for (size_t i = 0; i < n; i += BLOCK_SIZE) {
+        const size_t m = std::min(BLOCK_SIZE, n - i);
+        ConvertRow(src + i, buf, m, scale, bias);
+        ConvertRow(buf, dst + i, m, 1.f, 0.f);
+    }
+}
+
+// ------------------------------ Filter (Scalar) ------------------------------
+// dst[i] = sum_j kernel[j] * srcs[j][i]
+void FilterRowScalar(const float* const* srcs, const float* kernel,
+                     size_t n_tap, float* dst, size_t begin, size_t n) {
+    for (size_t i = begin; i < n; i++) {
+        float acc = 0.f;
+        for (size_t j = 0; j < n_tap; j++) {
+            acc += kernel[j] * srcs[j][i];
+        }
+        dst[i] = acc;
+    }
+}
+
+// ------------------------------- Filter (SSE2) -------------------------------
+#if defined(OGLW_SIMD_SSE2)
+size_t FilterRowSse2(const float* const* srcs, const float* kernel,
+                     size_t n_tap, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128 acc[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+                         _mm_setzero_ps()};
+        for (size_t j = 0; j < n_tap; j++) {
+            const __m128 k = _mm_set1_ps(kernel[j]);
+            const float* src = srcs[j] + i;
+            for (size_t v = 0; v < 4; v++) {
+                const __m128 s = _mm_loadu_ps(src + v * 4);
+                acc[v] = _mm_add_ps(acc[v], _mm_mul_ps(k, s));
+            }
+        }
+        for (size_t v = 0; v < 4; v++) {
+            _mm_storeu_ps(dst + i + v * 4, acc[v]);
+        }
+    }
+    return i;
+}
+#endif
+
+// ------------------------------- Filter (AVX2) -------------------------------
+#if defined(OGLW_SIMD_AVX2)
+OGLW_TARGET_AVX2
+size_t FilterRowAvx2(const float* const* srcs, const float* kernel,
+                     size_t n_tap, float* dst, size_t n) {
+    // 4 accumulators to hide the latency of addition
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(),
+                         _mm256_setzero_ps(), _mm256_setzero_ps()};
+        for (size_t j = 0; j < n_tap; j++) {
+            const __m256 k = _mm256_set1_ps(kernel[j]);
+            const float* src = srcs[j] + i;
+            for (size_t v = 0; v < 4; v++) {
+                const __m256 s = _mm256_loadu_ps(src + v * 8);
+                acc[v] = _mm256_add_ps(acc[v], _mm256_mul_ps(k, s));
+            }
+        }
+        for (size_t v = 0; v < 4; v++) {
+            _mm256_storeu_ps(dst + i + v * 8, acc[v]);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (size_t j = 0; j < n_tap; j++) {
+            const __m256 k = _mm256_set1_ps(kernel[j]);
+            const __m256 s = _mm256_loadu_ps(srcs[j] + i);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(k, s));
+        }
+        _mm256_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+#endif
+
+// ----------------------------- Resample (Scalar) -----------------------------
+// dst[x * d + z] = sum_k weights[x * n_tap + k] *
+//                  src[indices[x * n_tap + k] * d + z]
+void ResampleRowScalar(const float* src, const size_t* indices,
+                       const float* weights, size_t n_tap, float* dst,
+                       size_t begin, size_t n_dst, size_t d) {
+    for (size_t x = begin; x < n_dst; x++) {
+        const size_t* idx = indices + x * n_tap;
+        const float* w = weights + x * n_tap;
+        for (size_t z = 0; z < d; z++) {
+            float acc = 0.f;
+            for (size_t k = 0; k < n_tap; k++) {
+                acc += w[k] * src[idx[k] * d + z];
+            }
+            dst[x * d + z] = acc;
+        }
+    }
+}
+
+// ------------------------------ Resample (SSE2) ------------------------------
+#if defined(OGLW_SIMD_SSE2)
+// Channels of a pixel in the lower lanes, without touching the next pixel
+template <size_t D>
+__m128 LoadPixelSse2(const float* p);
+
+template <>
+__m128 LoadPixelSse2<2>(const float* p) {
+    return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+}
+
+template <>
+__m128 LoadPixelSse2<3>(const float* p) {
+    return _mm_movelh_ps(LoadPixelSse2<2>(p), _mm_load_ss(p + 2));
+}
+
+template <>
+__m128 LoadPixelSse2<4>(const float* p) {
+    return _mm_loadu_ps(p);
+}
+
+template <size_t D>
+void StorePixelSse2(float* p, __m128 v);
+
+template <>
+void StorePixelSse2<2>(float* p, __m128 v) {
+    _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+}
+
+template <>
+void StorePixelSse2<3>(float* p, __m128 v) {
+    StorePixelSse2<2>(p, v);
+    _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+
+template <>
+void StorePixelSse2<4>(float* p, __m128 v) {
+    _mm_storeu_ps(p, v);
+}
+
+// Channels of each pixel in a vector
+template <size_t D>
+size_t ResampleRowSse2(const float* src, const size_t* indices,
+                       const float* weights, size_t n_tap, float* dst,
+                       size_t n_dst) {
+    for (size_t x = 0; x < n_dst; x++) {
+        const size_t* idx = indices + x * n_tap;
+        const float* w = weights + x * n_tap;
+        __m128 acc = _mm_setzero_ps();
+        for (size_t k = 0; k < n_tap; k++) {
+            const __m128 s = LoadPixelSse2<D>(src + idx[k] * D);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), s));
+        }
+        StorePixelSse2<D>(dst + x * D, acc);
+    }
+    return n_dst;
+}
+
+// 4 pixels in a vector for a single channel
+template <>
+size_t ResampleRowSse2<1>(const float* src, const size_t* indices,
+                          const float* weights, size_t n_tap, float* dst,
+                          size_t n_dst) {
+    size_t x = 0;
+    for (; x + 4 <= n_dst; x += 4) {
+        const size_t* idx = indices + x * n_tap;
+        const float* w = weights + x * n_tap;
+        __m128 acc = _mm_setzero_ps();
+        for (size_t k = 0; k < n_tap; k++) {
+            const __m128 s = _mm_setr_ps(
+                    src[idx[k]], src[idx[n_tap + k]], src[idx[2 * n_tap + k]],
+                    src[idx[3 * n_tap + k]]);
+            const __m128 wk = _mm_setr_ps(w[k], w[n_tap + k], w[2 * n_tap + k],
+                                          w[3 * n_tap + k]);
+            acc = _mm_add_ps(acc, _mm_mul_ps(wk, s));
+        }
+        _mm_storeu_ps(dst + x, acc);
+    }
+    return x;
+}
+
+// Other depths are left to the scalar loop
+template <>
+size_t ResampleRowSse2<0>(const float*, const size_t*, const float*, size_t,
+                          float*, size_t) {
+    return 0;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+
+}  // namespace
+
+// ============================== Image Conversion =============================
+void ConvertRow(const uint8_t* src, uint8_t* dst, size_t n, float scale,
+                float bias) {
+    if (IsIdentity(scale, bias)) {
+        std::memcpy(dst, src, n);
+        return;
+    }
+    // Only 256 possible values
+    uint8_t table[256];
+    for (size_t v = 0; v < 256; v++) {
+        table[v] = FromFloat<uint8_t>(static_cast<float>(v) * scale + bias);
+    }
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = table[src[i]];
+    }
+}
+
+void ConvertRow(const uint8_t* src, uint16_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const uint8_t* src, float* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowSimd(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const uint8_t* src, Float16* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+// -----------------------------------------------------------------------------
+void ConvertRow(const uint16_t* src, uint8_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const uint16_t* src, uint16_t* dst, size_t n, float scale,
+                float bias) {
+    if (IsIdentity(scale, bias)) {
+        std::memcpy(dst, src, n * sizeof(uint16_t));
+        return;
+    }
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const uint16_t* src, float* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowSimd(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const uint16_t* src, Float16* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+// -----------------------------------------------------------------------------
+void ConvertRow(const float* src, uint8_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowSimd(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const float* src, uint16_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowSimd(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const float* src, float* dst, size_t n, float scale,
+                float bias) {
+    if (IsIdentity(scale, bias)) {
+        std::memcpy(dst, src, n * sizeof(float));
+        return;
+    }
+    ConvertRowSimd(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const float* src, Float16* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowHalf(src, dst, n, scale, bias);
+}
+
+// -----------------------------------------------------------------------------
+void ConvertRow(const Float16* src, uint8_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const Float16* src, uint16_t* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const Float16* src, float* dst, size_t n, float scale,
+                float bias) {
+    ConvertRowHalf(src, dst, n, scale, bias);
+}
+
+void ConvertRow(const Float16* src, Float16* dst, size_t n, float scale,
+                float bias) {
+    if (IsIdentity(scale, bias)) {
+        std::memcpy(dst, src, n * sizeof(Float16));
+        return;
+    }
+    ConvertRowViaFloat(src, dst, n, scale, bias);
+}
+
+// ================================= Row Filter ================================
+void FilterRow(const float* const* srcs, const float* kernel, size_t n_tap,
+               float* dst, size_t n) {
+    size_t i = 0;
+#if defined(OGLW_SIMD_AVX2)
+    if (UseAvx2()) {
+        i = FilterRowAvx2(srcs, kernel, n_tap, dst, n);
+    } else {
+        i = FilterRowSse2(srcs, kernel, n_tap, dst, n);
+    }
+#elif defined(OGLW_SIMD_SSE2)
+    i = FilterRowSse2(srcs, kernel, n_tap, dst, n);
+#endif
+    FilterRowScalar(srcs, kernel, n_tap, dst, i, n);
+}
+
+void ResampleRow(const float* src, const size_t* indices,
+                 const float* weights, size_t n_tap, float* dst, size_t n_dst,
+                 size_t d) {
+    size_t x = 0;
+#if defined(OGLW_SIMD_SSE2)
+    DispatchDepth(d, [&](auto depth) {
+        // AVX2 is not faster, where loads of scattered taps dominate
+        constexpr size_t D = decltype(depth)::value;
+        x = ResampleRowSse2<D>(src, indices, weights, n_tap, dst, n_dst);
+    });
+#endif
+    ResampleRowScalar(src, indices, weights, n_tap, dst, x, n_dst, d);
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
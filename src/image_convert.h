@@ -0,0 +1,77 @@
+#ifndef IMAGE_CONVERT_H_190510
+#define IMAGE_CONVERT_H_190510
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <oglw/float16.h>
+
+namespace oglw {
+
+// ============================== Image Conversion =============================
+// Convert `n` contiguous elements as `dst = src * scale + bias`.
+// Conversion to integers is rounded to nearest and clamped to their range.
+// SIMD kernels (SSE2/AVX2/F16C) are chosen by the running CPU.
+void ConvertRow(const uint8_t* src, uint8_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint8_t* src, uint16_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint8_t* src, float* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint8_t* src, Float16* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint16_t* src, uint8_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint16_t* src, uint16_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint16_t* src, float* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const uint16_t* src, Float16* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const float* src, uint8_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const float* src, uint16_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const float* src, float* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const float* src, Float16* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const Float16* src, uint8_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const Float16* src, uint16_t* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const Float16* src, float* dst, size_t n, float scale,
+                float bias);
+void ConvertRow(const Float16* src, Float16* dst, size_t n, float scale,
+                float bias);
+
+// =============================== Depth Dispatch ==============================
+// Call `func(std::integral_constant<size_t, D>())`, where `D` is `d` for common
+// depths, so that loops over channels are unrolled. (0 for the others)
+template <typename F>
+void DispatchDepth(size_t d, F func) {
+    switch (d) {
+        case 1: func(std::integral_constant<size_t, 1>()); break;
+        case 2: func(std::integral_constant<size_t, 2>()); break;
+        case 3: func(std::integral_constant<size_t, 3>()); break;
+        case 4: func(std::integral_constant<size_t, 4>()); break;
+        default: func(std::integral_constant<size_t, 0>()); break;
+    }
+}
+
+// ================================= Row Filter ================================
+// `dst[i] = sum_j kernel[j] * srcs[j][i]` for `n` values (SIMD), whose
+// summation order is the same on all CPUs.
+void FilterRow(const float* const* srcs, const float* kernel, size_t n_tap,
+               float* dst, size_t n);
+// Resample a row of `d` channels into `n_dst` pixels (SIMD), where pixel `x`
+// is the sum of `n_tap` source pixels `indices[x * n_tap + k]` weighted by
+// `weights[x * n_tap + k]`. The summation order is the same as `FilterRow`.
+void ResampleRow(const float* src, const size_t* indices,
+                 const float* weights, size_t n_tap, float* dst, size_t n_dst,
+                 size_t d);
+
+}  // namespace oglw
+
+#endif /* end of include guard */
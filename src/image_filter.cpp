@@ -0,0 +1,313 @@
+#include <oglw/image_filter.h>
+
+#include "fast_array.h"
+#include "image_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace oglw {
+
+namespace {
+
+// -----------------------------------------------------------------------------
+// Images with fewer values are filtered in the calling thread
+constexpr size_t FILTER_INLINE_SIZE = 16 * 1024;
+// Float rows of a band, which stay in L2 between the two passes
+constexpr size_t FILTER_BAND_BYTES = 128 * 1024;
+constexpr size_t FILTER_MIN_BAND_HEIGHT = 8;
+
+// Separable (`xs` and `ys`) or 2D (`values`) kernel
+struct FilterKernel {
+    size_t w = 0, h = 0;
+    std::vector<float> xs, ys;
+    std::vector<float> values;
+
+    bool isSeparable() const {
+        return values.empty();
+    }
+};
+
+void CheckKernelSize(size_t size) {
+    if (size % 2 == 0) {
+        throw std::runtime_error("Filter kernel size must be odd: " +
+                                 std::to_string(size));
+    }
+}
+
+// Index of the source pixel for `i`, or -1 for zero
+ptrdiff_t MapBorder(ptrdiff_t i, ptrdiff_t n, BorderMode border) {
+    if (0 <= i && i < n) {
+        return i;
+    }
+    switch (border) {
+        case BorderMode::CLAMP: return (i < 0) ? 0 : n - 1;
+        case BorderMode::REFLECT: {
+            if (n == 1) {
+                return 0;
+            }
+            const ptrdiff_t period = 2 * (n - 1);
+            i %= period;
+            i = (i < 0) ? i + period : i;
+            return (i < n) ? i : period - i;
+        }
+        case BorderMode::WRAP: i %= n; return (i < 0) ? i + n : i;
+        case BorderMode::ZERO: break;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Convert a row into float with `rx` border pixels on each side
+template <typename S>
+void LoadPaddedRow(const S* src, float* dst, size_t w, size_t d, size_t rx,
+                   BorderMode border) {
+    if (src == nullptr) {
+        // Zero border
+        std::fill(dst, dst + (w + 2 * rx) * d, 0.f);
+        return;
+    }
+    ConvertRow(src, dst + rx * d, w * d, 1.f, 0.f);
+    const ptrdiff_t w_i = static_cast<ptrdiff_t>(w);
+    const ptrdiff_t rx_i = static_cast<ptrdiff_t>(rx);
+    auto fill_border = [&](ptrdiff_t x) {
+        float* pix = dst + static_cast<size_t>(x + rx_i) * d;
+        const ptrdiff_t sx = MapBorder(x, w_i, border);
+        if (sx < 0) {
+            std::fill(pix, pix + d, 0.f);
+        } else {
+            const float* s = dst + static_cast<size_t>(sx + rx_i) * d;
+            std::copy(s, s + d, pix);
+        }
+    };
+    for (ptrdiff_t x = 1; x <= rx_i; x++) {
+        fill_border(-x);
+        fill_border(w_i - 1 + x);
+    }
+}
+
+// Filter a plane of interleaved pixels by bands of rows
+template <typename S, typename D>
+void FilterPlane(const S* src, size_t src_stride, D* dst, size_t dst_stride,
+                 size_t w, size_t h, size_t d, const FilterKernel& kernel,
+                 BorderMode border) {
+    const size_t rx = kernel.w / 2, ry = kernel.h / 2;
+    const size_t row_size = w * d;
+    const size_t pad_size = (w + 2 * rx) * d;
+    const bool separable = kernel.isSeparable();
+    // Rows after the first pass
+    const size_t mid_size = separable ? row_size : pad_size;
+
+    // Band height to fit in cache, and to split over workers
+    const size_t n_task = (GetParallelWorkerCount() + 1) * 4;
+    size_t band_h = FILTER_BAND_BYTES / (mid_size * sizeof(float));
+    band_h = std::min(band_h, (h + n_task - 1) / n_task);
+    band_h = std::max(band_h, FILTER_MIN_BAND_HEIGHT);
+    const size_t n_band = (h + band_h - 1) / band_h;
+    const size_t n_worker = (row_size * h < FILTER_INLINE_SIZE) ? 1 : 0;
+
+    ParallelFor(n_band, [&](size_t b_begin, size_t b_end) {
+        FastArray<float> pad(pad_size), acc(row_size);
+        FastArray<float> mid((band_h + 2 * ry) * mid_size);
+        std::vector<const float*> srcs(separable ? std::max(kernel.w, kernel.h)
+                                                 : kernel.w * kernel.h);
+        for (size_t b = b_begin; b < b_end; b++) {
+            const size_t y_begin = b * band_h;
+            const size_t y_end = std::min(y_begin + band_h, h);
+            const size_t n_mid = y_end - y_begin + 2 * ry;
+
+            // Horizontal pass (or just padding for 2D kernels)
+            for (size_t i = 0; i < n_mid; i++) {
+                const ptrdiff_t y = static_cast<ptrdiff_t>(y_begin + i) -
+                                    static_cast<ptrdiff_t>(ry);
+                const ptrdiff_t sy =
+                        MapBorder(y, static_cast<ptrdiff_t>(h), border);
+                const S* src_row =
+                        (sy < 0) ? nullptr
+                                 : src + static_cast<size_t>(sy) * src_stride;
+                float* mid_row = mid.data() + i * mid_size;
+                if (!separable) {
+                    LoadPaddedRow(src_row, mid_row, w, d, rx, border);
+                    continue;
+                }
+                LoadPaddedRow(src_row, pad.data(), w, d, rx, border);
+                for (size_t j = 0; j < kernel.w; j++) {
+                    srcs[j] = pad.data() + j * d;
+                }
+                FilterRow(srcs.data(), kernel.xs.data(), kernel.w, mid_row,
+                          row_size);
+            }
+
+            // Vertical pass (or 2D)
+            for (size_t y = y_begin; y < y_end; y++) {
+                const float* mid_top = mid.data() + (y - y_begin) * mid_size;
+                if (separable) {
+                    for (size_t j = 0; j < kernel.h; j++) {
+                        srcs[j] = mid_top + j * mid_size;
+                    }
+                    FilterRow(srcs.data(), kernel.ys.data(), kernel.h,
+                              acc.data(), row_size);
+                } else {
+                    for (size_t j = 0; j < kernel.h; j++) {
+                        for (size_t t = 0; t < kernel.w; t++) {
+                            srcs[j * kernel.w + t] =
+                                    mid_top + j * mid_size + t * d;
+                        }
+                    }
+                    FilterRow(srcs.data(), kernel.values.data(),
+                              kernel.w * kernel.h, acc.data(), row_size);
+                }
+                ConvertRow(acc.data(), dst + y * dst_stride, row_size, 1.f,
+                           0.f);
+            }
+        }
+    }, n_worker);
+}
+
+template <typename S, typename D>
+CpuImagePtr<D> FilterImage(const CpuImage<S>& src, const FilterKernel& kernel,
+                           BorderMode border) {
+    const size_t w = src.getWidth(), h = src.getHeight(), d = src.getDepth();
+    const ImageLayout layout = src.getLayout();
+    auto dst = CpuImage<D>::Create(w, h, d, size_t(0), layout);
+    if (w == 0 || h == 0 || d == 0) {
+        return dst;
+    }
+    const S* src_data = src.data();
+    D* dst_data = dst->data();
+    const size_t src_stride = src.getRowStride();
+    const size_t dst_stride = dst->getRowStride();
+    if (layout == ImageLayout::PLANAR) {
+        // Each plane as a single channel image
+        for (size_t z = 0; z < d; z++) {
+            FilterPlane(src_data + z * h * src_stride, src_stride,
+                        dst_data + z * h * dst_stride, dst_stride, w, h, 1,
+                        kernel, border);
+        }
+    } else {
+        FilterPlane(src_data, src_stride, dst_data, dst_stride, w, h, d,
+                    kernel, border);
+    }
+    return dst;
+}
+
+FilterKernel MakeSeparableKernel(const std::vector<float>& kernel_x,
+                                 const std::vector<float>& kernel_y) {
+    CheckKernelSize(kernel_x.size());
+    CheckKernelSize(kernel_y.size());
+    FilterKernel kernel;
+    kernel.w = kernel_x.size();
+    kernel.h = kernel_y.size();
+    kernel.xs = kernel_x;
+    kernel.ys = kernel_y;
+    return kernel;
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace
+
+// =============================== Image Filter ================================
+template <typename T>
+CpuImagePtr<T> FilterSeparable(const CpuImage<T>& src,
+                               const std::vector<float>& kernel_x,
+                               const std::vector<float>& kernel_y,
+                               BorderMode border) {
+    return FilterImage<T, T>(src, MakeSeparableKernel(kernel_x, kernel_y),
+                             border);
+}
+
+template <typename T>
+CpuImagePtr<T> Convolve(const CpuImage<T>& src,
+                        const std::vector<float>& kernel, size_t kernel_w,
+                        size_t kernel_h, BorderMode border) {
+    CheckKernelSize(kernel_w);
+    CheckKernelSize(kernel_h);
+    if (kernel.size() != kernel_w * kernel_h) {
+        throw std::runtime_error("Invalid filter kernel size");
+    }
+    FilterKernel kernel_2d;
+    kernel_2d.w = kernel_w;
+    kernel_2d.h = kernel_h;
+    kernel_2d.values = kernel;
+    return FilterImage<T, T>(src, kernel_2d, border);
+}
+
+template <typename T>
+CpuImagePtr<T> GaussianBlur(const CpuImage<T>& src, float sigma,
+                            BorderMode border) {
+    const std::vector<float> kernel = GetGaussianKernel(sigma);
+    return FilterSeparable(src, kernel, kernel, border);
+}
+
+template <typename T>
+CpuImagePtr<T> BoxBlur(const CpuImage<T>& src, size_t radius,
+                       BorderMode border) {
+    const size_t size = 2 * radius + 1;
+    const std::vector<float> kernel(size, 1.f / static_cast<float>(size));
+    return FilterSeparable(src, kernel, kernel, border);
+}
+
+template <typename T>
+CpuImagePtr<float> Sobel(const CpuImage<T>& src, size_t dx, size_t dy,
+                         BorderMode border) {
+    const std::vector<float> diff = {-1.f, 0.f, 1.f};
+    const std::vector<float> smooth = {1.f, 2.f, 1.f};
+    if (dx == 1 && dy == 0) {
+        return FilterImage<T, float>(src, MakeSeparableKernel(diff, smooth),
+                                     border);
+    } else if (dx == 0 && dy == 1) {
+        return FilterImage<T, float>(src, MakeSeparableKernel(smooth, diff),
+                                     border);
+    }
+    throw std::runtime_error("Sobel supports only (dx, dy) = (1, 0), (0, 1)");
+}
+
+std::vector<float> GetGaussianKernel(float sigma, size_t radius) {
+    if (!(0.f < sigma)) {
+        throw std::runtime_error("Gaussian sigma must be positive");
+    }
+    if (radius == 0) {
+        radius = static_cast<size_t>(std::ceil(3.f * sigma));
+    }
+    std::vector<float> kernel(2 * radius + 1);
+    float sum = 0.f;
+    for (size_t i = 0; i < kernel.size(); i++) {
+        const float x = static_cast<float>(i) - static_cast<float>(radius);
+        kernel[i] = std::exp(-x * x / (2.f * sigma * sigma));
+        sum += kernel[i];
+    }
+    for (auto&& v : kernel) {
+        v /= sum;
+    }
+    return kernel;
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ Specialization -------------------------------
+// -----------------------------------------------------------------------------
+#define OGLW_INSTANTIATE_FILTER(T)                                            \
+    template CpuImagePtr<T> FilterSeparable(const CpuImage<T>&,               \
+                                            const std::vector<float>&,        \
+                                            const std::vector<float>&,        \
+                                            BorderMode);                      \
+    template CpuImagePtr<T> Convolve(const CpuImage<T>&,                      \
+                                     const std::vector<float>&, size_t,       \
+                                     size_t, BorderMode);                     \
+    template CpuImagePtr<T> GaussianBlur(const CpuImage<T>&, float,           \
+                                         BorderMode);                         \
+    template CpuImagePtr<T> BoxBlur(const CpuImage<T>&, size_t, BorderMode); \
+    template CpuImagePtr<float> Sobel(const CpuImage<T>&, size_t, size_t,     \
+                                      BorderMode);
+OGLW_INSTANTIATE_FILTER(uint8_t)
+OGLW_INSTANTIATE_FILTER(uint16_t)
+OGLW_INSTANTIATE_FILTER(float)
+OGLW_INSTANTIATE_FILTER(Float16)
+#undef OGLW_INSTANTIATE_FILTER
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
@@ -0,0 +1,470 @@
+#include <oglw/image_transform.h>
+
+#include "fast_array.h"
+#include "image_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace oglw {
+
+namespace {
+
+// -----------------------------------------------------------------------------
+// Images with fewer values are transformed in the calling thread
+constexpr size_t TRANSFORM_INLINE_SIZE = 16 * 1024;
+// Float rows of a band, which stay in L2 between the two passes of resize
+constexpr size_t RESIZE_BAND_BYTES = 128 * 1024;
+// Side of square blocks (pixels) for transpose and rotation
+constexpr size_t TRANSPOSE_BLOCK_SIZE = 32;
+
+size_t GetNumWorker(size_t n_value) {
+    return (n_value < TRANSFORM_INLINE_SIZE) ? 1 : 0;
+}
+
+// ---------------------------------- Resize -----------------------------------
+double GetFilterRadius(ResizeFilter filter) {
+    switch (filter) {
+        case ResizeFilter::BILINEAR: return 1.0;
+        case ResizeFilter::BICUBIC: return 2.0;
+        case ResizeFilter::LANCZOS3: return 3.0;
+        case ResizeFilter::BOX: return 0.5;
+        case ResizeFilter::KAISER: return 3.0;
+    }
+    return 1.0;
+}
+
+// Modified Bessel function of the first kind (order 0) by its series
+double BesselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    const double q = x * x * 0.25;
+    for (int k = 1; k < 32 && sum * 1e-16 < term; k++) {
+        term *= q / static_cast<double>(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+double GetFilterWeight(ResizeFilter filter, double x) {
+    const double PI = 3.14159265358979323846;
+    x = std::abs(x);
+    switch (filter) {
+        case ResizeFilter::BILINEAR: return std::max(1.0 - x, 0.0);
+        case ResizeFilter::BICUBIC: {
+            const double a = -0.5;
+            if (x < 1.0) {
+                return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            } else if (x < 2.0) {
+                return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+            }
+            return 0.0;
+        }
+        case ResizeFilter::LANCZOS3: {
+            if (x < 1e-8) {
+                return 1.0;
+            } else if (x < 3.0) {
+                const double px = PI * x;
+                return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+            }
+            return 0.0;
+        }
+        case ResizeFilter::BOX: {
+            // Half of pixels on the edge
+            return (x < 0.5) ? 1.0 : (x == 0.5) ? 0.5 : 0.0;
+        }
+        case ResizeFilter::KAISER: {
+            const double ALPHA = 4.0;
+            if (3.0 <= x) {
+                return 0.0;
+            }
+            const double px = PI * x;
+            const double sinc = (x < 1e-8) ? 1.0 : std::sin(px) / px;
+            const double t = x / 3.0;
+            return sinc * BesselI0(ALPHA * std::sqrt(1.0 - t * t)) /
+                   BesselI0(ALPHA);
+        }
+    }
+    return 0.0;
+}
+
+// Taps of each destination pixel on one axis
+struct ResampleWeights {
+    size_t n_tap = 0;
+    std::vector<size_t> indices;  // Source indices clamped into the image
+    std::vector<float> weights;   // Normalized
+};
+
+ResampleWeights ComputeResampleWeights(size_t n_src, size_t n_dst,
+                                       ResizeFilter filter) {
+    const double scale = static_cast<double>(n_src) /
+                         static_cast<double>(n_dst);
+    const double widen = std::max(scale, 1.0);
+    const double support = GetFilterRadius(filter) * widen;
+
+    ResampleWeights rw;
+    rw.n_tap = static_cast<size_t>(std::ceil(support * 2.0)) + 1;
+    rw.indices.resize(n_dst * rw.n_tap);
+    rw.weights.resize(n_dst * rw.n_tap);
+    const ptrdiff_t last = static_cast<ptrdiff_t>(n_src) - 1;
+    std::vector<double> ws(rw.n_tap);
+    for (size_t i = 0; i < n_dst; i++) {
+        const double center = (static_cast<double>(i) + 0.5) * scale - 0.5;
+        const double first = std::ceil(center - support);
+        double sum = 0.0;
+        for (size_t k = 0; k < rw.n_tap; k++) {
+            const double x = first + static_cast<double>(k);
+            ws[k] = GetFilterWeight(filter, (x - center) / widen);
+            sum += ws[k];
+            const ptrdiff_t idx = static_cast<ptrdiff_t>(x);
+            rw.indices[i * rw.n_tap + k] =
+                    static_cast<size_t>(std::min(std::max(idx, ptrdiff_t(0)),
+                                                 last));
+        }
+        for (size_t k = 0; k < rw.n_tap; k++) {
+            rw.weights[i * rw.n_tap + k] = static_cast<float>(ws[k] / sum);
+        }
+    }
+    return rw;
+}
+
+template <typename T>
+void ResizePlane(const T* src, size_t src_w, size_t src_h, size_t src_stride,
+                 T* dst, size_t dst_w, size_t dst_h, size_t dst_stride,
+                 size_t d, const ResampleWeights& rw_x,
+                 const ResampleWeights& rw_y) {
+    const size_t src_row_size = src_w * d;
+    const size_t row_size = dst_w * d;
+    const size_t n_tap = rw_y.n_tap;
+
+    // Bands of destination rows, whose source rows fit in cache
+    const double scale_y = std::max(static_cast<double>(src_h) /
+                                            static_cast<double>(dst_h),
+                                    1.0);
+    const size_t n_task = (GetParallelWorkerCount() + 1) * 4;
+    size_t band_h = static_cast<size_t>(
+            static_cast<double>(RESIZE_BAND_BYTES) /
+            (static_cast<double>(row_size * sizeof(float)) * scale_y));
+    band_h = std::min(band_h, (dst_h + n_task - 1) / n_task);
+    band_h = std::max(band_h, size_t(1));
+    const size_t n_band = (dst_h + band_h - 1) / band_h;
+
+    ParallelFor(n_band, [&](size_t b_begin, size_t b_end) {
+        FastArray<float> src_row(src_row_size), acc(row_size), mid;
+        std::vector<const float*> srcs(n_tap);
+        for (size_t b = b_begin; b < b_end; b++) {
+            const size_t y_begin = b * band_h;
+            const size_t y_end = std::min(y_begin + band_h, dst_h);
+            // Source rows are monotonic in taps and rows
+            const size_t sy_begin = rw_y.indices[y_begin * n_tap];
+            const size_t sy_end = rw_y.indices[y_end * n_tap - 1] + 1;
+
+            // Horizontal pass
+            mid.alloc((sy_end - sy_begin) * row_size);
+            for (size_t sy = sy_begin; sy < sy_end; sy++) {
+                ConvertRow(src + sy * src_stride, src_row.data(),
+                           src_row_size, 1.f, 0.f);
+                ResampleRow(src_row.data(), rw_x.indices.data(),
+                            rw_x.weights.data(), rw_x.n_tap,
+                            mid.data() + (sy - sy_begin) * row_size, dst_w,
+                            d);
+            }
+
+            // Vertical pass
+            for (size_t y = y_begin; y < y_end; y++) {
+                for (size_t k = 0; k < n_tap; k++) {
+                    const size_t sy = rw_y.indices[y * n_tap + k];
+                    srcs[k] = mid.data() + (sy - sy_begin) * row_size;
+                }
+                FilterRow(srcs.data(), rw_y.weights.data() + y * n_tap, n_tap,
+                          acc.data(), row_size);
+                ConvertRow(acc.data(), dst + y * dst_stride, row_size, 1.f,
+                           0.f);
+            }
+        }
+    }, GetNumWorker(row_size * dst_h));
+}
+
+// ---------------------------------- Mipmap -----------------------------------
+// Average 2x2 pixels into `dst_w` x `dst_h`
+template <typename T>
+void HalvePlane(const T* src, size_t src_stride, T* dst, size_t dst_w,
+                size_t dst_h, size_t dst_stride, size_t d) {
+    const size_t row_size = dst_w * d;
+    DispatchDepth(d, [&](auto depth) {
+        constexpr size_t D = decltype(depth)::value;
+        const size_t n_ch = (D == 0) ? d : D;
+        ParallelFor(dst_h, [&](size_t y_begin, size_t y_end) {
+            FastArray<float> row0(row_size * 2), row1(row_size * 2);
+            FastArray<float> acc(row_size);
+            for (size_t y = y_begin; y < y_end; y++) {
+                ConvertRow(src + y * 2 * src_stride, row0.data(),
+                           row_size * 2, 1.f, 0.f);
+                ConvertRow(src + (y * 2 + 1) * src_stride, row1.data(),
+                           row_size * 2, 1.f, 0.f);
+                float* sum = row0.data();
+                const float* lower = row1.data();
+                for (size_t i = 0; i < row_size * 2; i++) {
+                    sum[i] += lower[i];
+                }
+                for (size_t x = 0; x < dst_w; x++) {
+                    const float* pair = sum + x * 2 * n_ch;
+                    for (size_t z = 0; z < n_ch; z++) {
+                        acc[x * n_ch + z] = (pair[z] + pair[n_ch + z]) * 0.25f;
+                    }
+                }
+                ConvertRow(acc.data(), dst + y * dst_stride, row_size, 1.f,
+                           0.f);
+            }
+        }, GetNumWorker(row_size * dst_h * 4));
+    });
+}
+
+template <typename T>
+CpuImagePtr<T> HalveImage(const CpuImage<T>& src) {
+    const size_t w = src.getWidth() / 2, h = src.getHeight() / 2;
+    const size_t d = src.getDepth();
+    auto dst = CpuImage<T>::Create(w, h, d, size_t(0), src.getLayout());
+    const size_t src_stride = src.getRowStride();
+    const size_t dst_stride = dst->getRowStride();
+    if (src.getLayout() == ImageLayout::PLANAR) {
+        for (size_t z = 0; z < d; z++) {
+            HalvePlane(src.data() + z * h * 2 * src_stride, src_stride,
+                       dst->data() + z * h * dst_stride, w, h, dst_stride, 1);
+        }
+    } else {
+        HalvePlane(src.data(), src_stride, dst->data(), w, h, dst_stride, d);
+    }
+    return dst;
+}
+
+// ------------------------------ Transpose/Rotate -----------------------------
+// Call `func(std::integral_constant<size_t, B>())`, where `B` is `n_bytes`
+// for common pixel sizes, so that pixels are copied as words. (0 for others)
+template <typename F>
+void DispatchPixelBytes(size_t n_bytes, F func) {
+    switch (n_bytes) {
+        case 1: func(std::integral_constant<size_t, 1>()); break;
+        case 2: func(std::integral_constant<size_t, 2>()); break;
+        case 3: func(std::integral_constant<size_t, 3>()); break;
+        case 4: func(std::integral_constant<size_t, 4>()); break;
+        case 6: func(std::integral_constant<size_t, 6>()); break;
+        case 8: func(std::integral_constant<size_t, 8>()); break;
+        case 12: func(std::integral_constant<size_t, 12>()); break;
+        case 16: func(std::integral_constant<size_t, 16>()); break;
+        default: func(std::integral_constant<size_t, 0>()); break;
+    }
+}
+
+// How source pixel (x, y) moves
+struct PixelMapping {
+    bool transpose = false;  // To (y, x)
+    bool flip_x = false;     // Then reverse destination x
+    bool flip_y = false;     // Then reverse destination y
+};
+
+PixelMapping GetRotateMapping(int n_turn) {
+    PixelMapping mapping;
+    switch (((n_turn % 4) + 4) % 4) {
+        case 1: mapping.transpose = mapping.flip_x = true; break;
+        case 2: mapping.flip_x = mapping.flip_y = true; break;
+        case 3: mapping.transpose = mapping.flip_y = true; break;
+    }
+    return mapping;
+}
+
+// Copy a plane of `w` x `h` pixels of `pix_bytes` by square blocks, so that
+// both reading and writing stay in cache lines.
+void RemapPlane(const uint8_t* src, size_t w, size_t h, size_t src_stride,
+                uint8_t* dst, size_t dst_stride, size_t pix_bytes,
+                const PixelMapping& mapping) {
+    const size_t dst_w = mapping.transpose ? h : w;
+    const size_t dst_h = mapping.transpose ? w : h;
+    // Destination step for each source x, and the position of (0, y)
+    const ptrdiff_t pix_i = static_cast<ptrdiff_t>(pix_bytes);
+    const ptrdiff_t stride_i = static_cast<ptrdiff_t>(dst_stride);
+    const ptrdiff_t step_dst_x = mapping.flip_x ? -pix_i : pix_i;
+    const ptrdiff_t step_dst_y = mapping.flip_y ? -stride_i : stride_i;
+    const ptrdiff_t step_x = mapping.transpose ? step_dst_y : step_dst_x;
+    const ptrdiff_t step_y = mapping.transpose ? step_dst_x : step_dst_y;
+    const size_t origin_x = mapping.flip_x ? dst_w - 1 : 0;
+    const size_t origin_y = mapping.flip_y ? dst_h - 1 : 0;
+    uint8_t* origin = dst + origin_y * dst_stride + origin_x * pix_bytes;
+
+    const size_t n_block_x = (w + TRANSPOSE_BLOCK_SIZE - 1) /
+                             TRANSPOSE_BLOCK_SIZE;
+    const size_t n_block_y = (h + TRANSPOSE_BLOCK_SIZE - 1) /
+                             TRANSPOSE_BLOCK_SIZE;
+    DispatchPixelBytes(pix_bytes, [&](auto bytes) {
+        constexpr size_t B = decltype(bytes)::value;
+        const size_t n_bytes = (B == 0) ? pix_bytes : B;
+        ParallelFor(n_block_x * n_block_y, [&](size_t t_begin, size_t t_end) {
+            for (size_t t = t_begin; t < t_end; t++) {
+                const size_t x_begin = (t % n_block_x) * TRANSPOSE_BLOCK_SIZE;
+                const size_t y_begin = (t / n_block_x) * TRANSPOSE_BLOCK_SIZE;
+                const size_t x_end =
+                        std::min(x_begin + TRANSPOSE_BLOCK_SIZE, w);
+                const size_t y_end =
+                        std::min(y_begin + TRANSPOSE_BLOCK_SIZE, h);
+                for (size_t y = y_begin; y < y_end; y++) {
+                    const uint8_t* s =
+                            src + y * src_stride + x_begin * n_bytes;
+                    uint8_t* p = origin + static_cast<ptrdiff_t>(y) * step_y +
+                                 static_cast<ptrdiff_t>(x_begin) * step_x;
+                    for (size_t x = x_begin; x < x_end; x++) {
+                        std::memcpy(p, s, n_bytes);
+                        s += n_bytes;
+                        p += step_x;
+                    }
+                }
+            }
+        }, GetNumWorker(w * h * pix_bytes));
+    });
+}
+
+template <typename T>
+CpuImagePtr<T> RemapImage(const CpuImage<T>& src,
+                          const PixelMapping& mapping) {
+    const size_t w = src.getWidth(), h = src.getHeight(), d = src.getDepth();
+    const ImageLayout layout = src.getLayout();
+    const size_t dst_w = mapping.transpose ? h : w;
+    const size_t dst_h = mapping.transpose ? w : h;
+    auto dst = CpuImage<T>::Create(dst_w, dst_h, d, size_t(0), layout);
+    if (w == 0 || h == 0 || d == 0) {
+        return dst;
+    }
+    const size_t src_stride = src.getRowStride();
+    const size_t dst_stride = dst->getRowStride();
+    const T* src_data = src.data();
+    T* dst_data = dst->data();
+    const size_t n_plane = (layout == ImageLayout::PLANAR) ? d : 1;
+    const size_t pix_d = d / n_plane;
+    for (size_t z = 0; z < n_plane; z++) {
+        const T* src_plane = src_data + z * h * src_stride;
+        T* dst_plane = dst_data + z * dst_h * dst_stride;
+        RemapPlane(reinterpret_cast<const uint8_t*>(src_plane), w, h,
+                   src_stride * sizeof(T),
+                   reinterpret_cast<uint8_t*>(dst_plane),
+                   dst_stride * sizeof(T), pix_d * sizeof(T), mapping);
+    }
+    return dst;
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace
+
+// ============================== Image Transform ==============================
+template <typename T>
+CpuImagePtr<T> Resize(const CpuImage<T>& src, size_t w, size_t h,
+                      ResizeFilter filter) {
+    const size_t src_w = src.getWidth(), src_h = src.getHeight();
+    const size_t d = src.getDepth();
+    auto dst = CpuImage<T>::Create(w, h, d, size_t(0), src.getLayout());
+    if (w == 0 || h == 0 || d == 0) {
+        return dst;
+    }
+    if (src_w == 0 || src_h == 0) {
+        throw std::runtime_error("Empty image cannot be resized");
+    }
+    const ResampleWeights rw_x = ComputeResampleWeights(src_w, w, filter);
+    const ResampleWeights rw_y = ComputeResampleWeights(src_h, h, filter);
+    const size_t src_stride = src.getRowStride();
+    const size_t dst_stride = dst->getRowStride();
+    if (src.getLayout() == ImageLayout::PLANAR) {
+        for (size_t z = 0; z < d; z++) {
+            ResizePlane(src.data() + z * src_h * src_stride, src_w, src_h,
+                        src_stride, dst->data() + z * h * dst_stride, w, h,
+                        dst_stride, 1, rw_x, rw_y);
+        }
+    } else {
+        ResizePlane(src.data(), src_w, src_h, src_stride, dst->data(), w, h,
+                    dst_stride, d, rw_x, rw_y);
+    }
+    return dst;
+}
+
+template <typename T>
+CpuImagePtr<T> Transpose(const CpuImage<T>& src) {
+    PixelMapping mapping;
+    mapping.transpose = true;
+    return RemapImage(src, mapping);
+}
+
+template <typename T>
+CpuImagePtr<T> Rotate90(const CpuImage<T>& src, int n_turn) {
+    return RemapImage(src, GetRotateMapping(n_turn));
+}
+
+template <typename T>
+void FlipVertical(CpuImage<T>& img) {
+    const size_t w = img.getWidth(), h = img.getHeight(), d = img.getDepth();
+    const size_t stride = img.getRowStride();
+    const bool planar = (img.getLayout() == ImageLayout::PLANAR);
+    const size_t n_plane = planar ? d : 1;
+    const size_t row_size = planar ? w : w * d;
+    T* data = img.data();
+    // Pairs of rows in all planes
+    const size_t n_pair = h / 2;
+    ParallelFor(n_plane * n_pair, [&](size_t p_begin, size_t p_end) {
+        for (size_t p = p_begin; p < p_end; p++) {
+            T* plane = data + (p / n_pair) * h * stride;
+            const size_t y = p % n_pair;
+            T* top = plane + y * stride;
+            T* bottom = plane + (h - 1 - y) * stride;
+            std::swap_ranges(top, top + row_size, bottom);
+        }
+    }, GetNumWorker(w * h * d));
+}
+
+// ================================== Mipmap ===================================
+template <typename T>
+std::vector<CpuImagePtr<T>> BuildMipmaps(const CpuImage<T>& src,
+                                         ResizeFilter filter, size_t n_level) {
+    const size_t w = src.getWidth(), h = src.getHeight();
+    if (src.empty()) {
+        throw std::runtime_error("Empty image has no mipmaps");
+    }
+    const size_t max_level = GetMipLevelCount(w, h);
+    n_level = (n_level == 0) ? max_level : std::min(n_level, max_level);
+
+    std::vector<CpuImagePtr<T>> levels;
+    levels.reserve(n_level);
+    levels.push_back(CpuImage<T>::Create(src));
+    for (size_t level = 1; level < n_level; level++) {
+        const CpuImage<T>& prev = *levels.back();
+        const size_t level_w = GetMipSize(w, level);
+        const size_t level_h = GetMipSize(h, level);
+        if (filter == ResizeFilter::BOX && prev.getWidth() == level_w * 2 &&
+            prev.getHeight() == level_h * 2) {
+            levels.push_back(HalveImage(prev));
+        } else {
+            levels.push_back(Resize(prev, level_w, level_h, filter));
+        }
+    }
+    return levels;
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ Specialization -------------------------------
+// -----------------------------------------------------------------------------
+#define OGLW_INSTANTIATE_TRANSFORM(T)                                       \
+    template CpuImagePtr<T> Resize(const CpuImage<T>&, size_t, size_t,      \
+                                   ResizeFilter);                           \
+    template CpuImagePtr<T> Transpose(const CpuImage<T>&);                  \
+    template CpuImagePtr<T> Rotate90(const CpuImage<T>&, int);              \
+    template void FlipVertical(CpuImage<T>&);                               \
+    template std::vector<CpuImagePtr<T>> BuildMipmaps(const CpuImage<T>&,   \
+                                                      ResizeFilter, size_t);
+OGLW_INSTANTIATE_TRANSFORM(uint8_t)
+OGLW_INSTANTIATE_TRANSFORM(uint16_t)
+OGLW_INSTANTIATE_TRANSFORM(float)
+OGLW_INSTANTIATE_TRANSFORM(Float16)
+#undef OGLW_INSTANTIATE_TRANSFORM
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
@@ -0,0 +1,103 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdexcept>
+
+namespace oglw {
+
+// ================================ Mapped File ================================
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& filename,
+                                             bool writable) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open: " + filename);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        throw std::runtime_error("Failed to map (empty): " + filename);
+    }
+    HANDLE mapping = CreateFileMappingA(
+            handle, nullptr, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0,
+            nullptr);
+    CloseHandle(handle);
+    if (!mapping) {
+        throw std::runtime_error("Failed to map: " + filename);
+    }
+    // The view keeps the mapping alive
+    void* ptr = MapViewOfFile(mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ,
+                              0, 0, 0);
+    CloseHandle(mapping);
+    if (!ptr) {
+        throw std::runtime_error("Failed to map: " + filename);
+    }
+    file->m_size = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open: " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to map (empty): " + filename);
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    const int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* ptr = mmap(nullptr, size, prot, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("Failed to map: " + filename);
+    }
+    file->m_size = size;
+#endif
+    file->m_data = static_cast<unsigned char*>(ptr);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+#else
+    munmap(m_data, m_size);
+#endif
+}
+
+unsigned char* MappedFile::data() const {
+    return m_data;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
+
+// -----------------------------------------------------------------------------
+void PrefetchFile(const std::string& filename) {
+#if defined(__linux__)
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    // Asynchronous read-ahead of the whole file
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+#else
+    (void)filename;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
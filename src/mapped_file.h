@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H_190512
+#define MAPPED_FILE_H_190512
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace oglw {
+
+// ================================ Mapped File ================================
+// Whole file mapped into memory. With `writable`, pages are private and
+// copied on the first write, which is never written back to the file.
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> Open(const std::string& filename,
+                                            bool writable);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    unsigned char* data() const;
+    size_t size() const;
+
+private:
+    MappedFile() {}
+
+    unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Start reading `filename` into the page cache in background, so that the
+// following read does not wait for the disk. Failures are ignored.
+void PrefetchFile(const std::string& filename);
+
+}  // namespace oglw
+
+#endif /* end of include guard */
@@ -0,0 +1,258 @@
+#include <oglw/memory_pool.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace oglw {
+
+namespace {
+
+// -----------------------------------------------------------------------------
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+size_t RoundUpHugePage(size_t n_bytes) {
+    return (n_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+unsigned char* MapPages(size_t n_bytes) {
+    n_bytes = RoundUpHugePage(n_bytes);
+#if defined(_WIN32)
+    void* ptr = VirtualAlloc(nullptr, n_bytes, MEM_RESERVE | MEM_COMMIT,
+                             PAGE_READWRITE);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return static_cast<unsigned char*>(ptr);
+#else
+    // Map extra space to align the head on huge page boundary
+    const size_t map_bytes = n_bytes + HUGE_PAGE_SIZE;
+    void* ptr = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    unsigned char* map_head = static_cast<unsigned char*>(ptr);
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    const size_t head_gap =
+            ((addr + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1)) - addr;
+    // Unmap unused head and tail
+    if (0 < head_gap) {
+        munmap(map_head, head_gap);
+    }
+    munmap(map_head + head_gap + n_bytes, HUGE_PAGE_SIZE - head_gap);
+    unsigned char* head = map_head + head_gap;
+#if defined(MADV_HUGEPAGE)
+    madvise(head, n_bytes, MADV_HUGEPAGE);  // Transparent huge page hint
+#endif
+    return head;
+#endif
+}
+
+void UnmapPages(unsigned char* ptr, size_t n_bytes) {
+#if defined(_WIN32)
+    (void)n_bytes;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, RoundUpHugePage(n_bytes));
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Round up to one of 4 classes per power of two (at most 25% waste)
+size_t GetSizeClass(size_t n_bytes) {
+    size_t pow2 = MEMORY_POOL_MIN_BYTES;
+    while (pow2 < n_bytes) {
+        pow2 <<= 1;
+    }
+    const size_t step = pow2 / 8;
+    return (n_bytes + step - 1) / step * step;
+}
+
+// -----------------------------------------------------------------------------
+class MemoryPool {
+public:
+    unsigned char* allocate(size_t n_bytes) {
+        if (m_map_threshold <= n_bytes) {
+            unsigned char* ptr = MapPages(n_bytes);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_mapped[ptr] = n_bytes;
+            m_stats.n_mapped++;
+            m_stats.mapped_bytes += n_bytes;
+            return ptr;
+        }
+
+        const size_t cls = GetSizeClass(n_bytes);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto itr = m_cache.find(cls);
+            if (itr != m_cache.end() && !itr->second.empty()) {
+                unsigned char* ptr = itr->second.back();
+                itr->second.pop_back();
+                m_stats.n_hit++;
+                m_stats.n_cached--;
+                m_stats.cached_bytes -= cls;
+                return ptr;
+            }
+            m_stats.n_miss++;
+        }
+        // Allocate out of the lock
+        return new unsigned char[cls];
+    }
+
+    void free(unsigned char* ptr, size_t n_bytes) {
+        const size_t cls = GetSizeClass(n_bytes);
+        bool mapped = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Mapped one (the threshold may be changed after allocation)
+            auto itr = m_mapped.find(ptr);
+            if (itr != m_mapped.end()) {
+                m_mapped.erase(itr);
+                m_stats.n_mapped--;
+                m_stats.mapped_bytes -= n_bytes;
+                mapped = true;
+            } else if (cls <= m_capacity) {
+                // Make a room for the new one, and cache
+                trimUnlocked(m_capacity - cls);
+                m_cache[cls].push_back(ptr);
+                m_stats.n_cached++;
+                m_stats.cached_bytes += cls;
+                return;
+            }
+        }
+        if (mapped) {
+            // Return to the OS
+            UnmapPages(ptr, n_bytes);
+        } else {
+            // Too large to be cached
+            delete[] ptr;
+        }
+    }
+
+    void setCapacity(size_t max_bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = max_bytes;
+        trimUnlocked(m_capacity);
+    }
+
+    size_t getCapacity() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_capacity;
+    }
+
+    void setMapThreshold(size_t n_bytes) {
+        m_map_threshold = n_bytes;
+    }
+
+    size_t getMapThreshold() {
+        return m_map_threshold;
+    }
+
+    void trim(size_t max_bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        trimUnlocked(max_bytes);
+    }
+
+    MemoryPoolStats getStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.n_hit = 0;
+        m_stats.n_miss = 0;
+    }
+
+private:
+    void trimUnlocked(size_t max_bytes) {
+        // Release from the largest class
+        auto itr = m_cache.rbegin();
+        while (max_bytes < m_stats.cached_bytes && itr != m_cache.rend()) {
+            auto& ptrs = itr->second;
+            while (max_bytes < m_stats.cached_bytes && !ptrs.empty()) {
+                delete[] ptrs.back();
+                ptrs.pop_back();
+                m_stats.n_cached--;
+                m_stats.cached_bytes -= itr->first;
+            }
+            ++itr;
+        }
+    }
+
+    std::mutex m_mutex;
+    std::map<size_t, std::vector<unsigned char*>> m_cache;
+    size_t m_capacity = 256 * 1024 * 1024;
+    std::atomic<size_t> m_map_threshold{256 * 1024 * 1024};
+    std::unordered_map<unsigned char*, size_t> m_mapped;
+    MemoryPoolStats m_stats;
+};
+
+MemoryPool& GetMemoryPool() {
+    // Never destructed, so that static arrays can be freed at exit.
+    static MemoryPool* pool = new MemoryPool();
+    return *pool;
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace
+
+// ================================ Memory Pool ================================
+unsigned char* PoolAllocate(size_t n_bytes) {
+    if (n_bytes < MEMORY_POOL_MIN_BYTES) {
+        return new unsigned char[n_bytes];
+    }
+    return GetMemoryPool().allocate(n_bytes);
+}
+
+void PoolFree(unsigned char* ptr, size_t n_bytes) {
+    if (n_bytes < MEMORY_POOL_MIN_BYTES) {
+        delete[] ptr;
+        return;
+    }
+    GetMemoryPool().free(ptr, n_bytes);
+}
+
+void SetMemoryPoolCapacity(size_t max_bytes) {
+    GetMemoryPool().setCapacity(max_bytes);
+}
+
+size_t GetMemoryPoolCapacity() {
+    return GetMemoryPool().getCapacity();
+}
+
+void SetMemoryPoolMapThreshold(size_t n_bytes) {
+    GetMemoryPool().setMapThreshold(n_bytes);
+}
+
+size_t GetMemoryPoolMapThreshold() {
+    return GetMemoryPool().getMapThreshold();
+}
+
+void TrimMemoryPool(size_t max_bytes) {
+    GetMemoryPool().trim(max_bytes);
+}
+
+MemoryPoolStats GetMemoryPoolStats() {
+    return GetMemoryPool().getStats();
+}
+
+void ResetMemoryPoolStats() {
+    GetMemoryPool().resetStats();
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
@@ -3,6 +3,8 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
 
+#include "fast_array.h"
+
 #include <cassert>
 #include <iostream>
 #include <map>
@@ -39,9 +41,9 @@ std::string EscapeDuplicatedKey(const std::string& name,
 
 // -----------------------------------------------------------------------------
 struct AttributeIndices {
-    std::vector<unsigned int> vertex;
-    std::vector<unsigned int> normal;
-    std::vector<unsigned int> texcoord;
+    FastArray<unsigned int> vertex;
+    FastArray<unsigned int> normal;
+    FastArray<unsigned int> texcoord;
 };
 
 void LoadObj(const std::string& filename, std::vector<float>& vertices,
@@ -67,9 +69,9 @@ void LoadObj(const std::string& filename, std::vector<float>& vertices,
         // Repack indices
         AttributeIndices idxs;
         auto& s_idxs = shape.mesh.indices;
-        idxs.vertex.resize(s_idxs.size());
-        idxs.normal.resize(s_idxs.size());
-        idxs.texcoord.resize(s_idxs.size());
+        idxs.vertex.alloc(s_idxs.size());
+        idxs.normal.alloc(s_idxs.size());
+        idxs.texcoord.alloc(s_idxs.size());
         for (size_t i = 0; i < s_idxs.size(); i++) {
             auto& s_idx = s_idxs[i];
             idxs.vertex[i] = static_cast<unsigned int>(s_idx.vertex_index);
@@ -77,13 +79,13 @@ void LoadObj(const std::string& filename, std::vector<float>& vertices,
             idxs.texcoord[i] = static_cast<unsigned int>(s_idx.texcoord_index);
         }
 
-        indices[EscapeDuplicatedKey(shape.name, indices)] = idxs;
+        indices[EscapeDuplicatedKey(shape.name, indices)] = std::move(idxs);
     }
 }
 
 // -----------------------------------------------------------------------------
 void AccumulateNormalCounts(const std::vector<float>& vertices,
-                            const std::vector<unsigned int>& indices,
+                            const FastArray<unsigned int>& indices,
                             std::vector<float>& normals,
                             std::vector<int>& normal_cnts) {
     for (size_t f_idx = 0; f_idx < indices.size() / 3; f_idx++) {
@@ -178,7 +180,7 @@ void CreateGeometryIndexingVtxOnly(
 
     for (auto& v : indices) {
         // Create index buffer
-        auto vtx_idxs = v.second.vertex;
+        const auto& vtx_idxs = v.second.vertex;
         auto index_buf = GpuIndexBuffer::Create(vtx_idxs.size(), 1);
         index_buf->sendData(vtx_idxs.data());
 
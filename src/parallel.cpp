@@ -0,0 +1,308 @@
+#include <oglw/parallel.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace oglw {
+
+namespace {
+
+// -----------------------------------------------------------------------------
+struct ParallelJob {
+    const std::function<void(size_t begin, size_t end)>* func = nullptr;
+    size_t n_left = 0;  // Number of unfinished tasks (guarded by `mutex`)
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+struct ParallelTask {
+    ParallelJob* job = nullptr;
+    size_t begin = 0, end = 0;
+};
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<ParallelTask> tasks;
+    std::deque<ParallelTask> pinned;  // Never stolen
+    std::atomic<size_t> n_pinned{0};
+};
+
+// Index of the worker running in this thread (SIZE_MAX: not a worker)
+thread_local size_t t_worker_idx = SIZE_MAX;
+
+void SetThreadAffinity(std::thread& thread, size_t cpu) {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t),
+                           &cpu_set);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Work-stealing thread pool. Each worker pops tasks from the back of its own
+// queue and steals from the front of the others when it runs out.
+class ThreadPool {
+public:
+    void configure(size_t n_worker, const std::vector<size_t>& cpus) {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        stop();
+        m_n_worker = n_worker;
+        m_cpus = cpus;
+    }
+
+    size_t getWorkerCount() {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        return getWorkerCountUnlocked();
+    }
+
+    bool isBound() {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        return !m_cpus.empty();
+    }
+
+    // With `pinned`, the i-th task is run only by the i-th worker, where
+    // `n_task` must be the number of workers.
+    void run(size_t n, const std::function<void(size_t, size_t)>& func,
+             size_t n_task, bool pinned = false) {
+        start();
+
+        // Split into tasks
+        ParallelJob job;
+        job.func = &func;
+        job.n_left = n_task;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!pinned) {
+                m_n_pending += n_task;
+            }
+            for (size_t i = 0; i < n_task; i++) {
+                TaskQueue& queue = *m_queues[i % m_queues.size()];
+                std::lock_guard<std::mutex> queue_lock(queue.mutex);
+                const ParallelTask task = {&job, n * i / n_task,
+                                           n * (i + 1) / n_task};
+                if (pinned) {
+                    queue.pinned.push_back(task);
+                    queue.n_pinned++;
+                } else {
+                    queue.tasks.push_back(task);
+                }
+            }
+        }
+        m_cond.notify_all();
+
+        // Help the workers until the job is finished
+        const size_t idx = std::min(t_worker_idx, m_queues.size());
+        while (true) {
+            ParallelTask task;
+            if (pop(idx, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(job.mutex);
+            job.cond.wait(lock, [&]() { return job.n_left == 0; });
+            break;
+        }
+
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+private:
+    size_t getWorkerCountUnlocked() const {
+        if (0 < m_n_worker) {
+            return m_n_worker;
+        }
+        // The calling thread also works
+        const size_t n_hw = std::thread::hardware_concurrency();
+        return std::max(n_hw, size_t(2)) - 1;
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        if (!m_workers.empty()) {
+            return;
+        }
+        // Start lazily
+        const size_t n_worker = getWorkerCountUnlocked();
+        m_stopping = false;
+        m_queues.clear();
+        for (size_t i = 0; i < n_worker; i++) {
+            m_queues.push_back(std::make_unique<TaskQueue>());
+        }
+        for (size_t i = 0; i < n_worker; i++) {
+            m_workers.emplace_back([this, i]() { work(i); });
+            if (!m_cpus.empty()) {
+                SetThreadAffinity(m_workers.back(), m_cpus[i % m_cpus.size()]);
+            }
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cond.notify_all();
+        for (auto&& worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    void work(size_t idx) {
+        t_worker_idx = idx;
+        TaskQueue& own_queue = *m_queues[idx];
+        while (true) {
+            ParallelTask task;
+            if (pop(idx, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [&]() {
+                return m_stopping || 0 < m_n_pending ||
+                       0 < own_queue.n_pinned;
+            });
+            if (m_stopping && m_n_pending == 0 && own_queue.n_pinned == 0) {
+                return;
+            }
+        }
+    }
+
+    bool pop(size_t idx, ParallelTask& task) {
+        const size_t n_queue = m_queues.size();
+        // Own queue from the back
+        if (idx < n_queue) {
+            TaskQueue& queue = *m_queues[idx];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.pinned.empty()) {
+                task = queue.pinned.front();
+                queue.pinned.pop_front();
+                queue.n_pinned--;
+                return true;
+            }
+            if (!queue.tasks.empty()) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+                m_n_pending--;
+                return true;
+            }
+        }
+        // Steal from the front
+        for (size_t i = 1; i <= n_queue; i++) {
+            TaskQueue& queue = *m_queues[(idx + i) % n_queue];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+                m_n_pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void execute(const ParallelTask& task) {
+        ParallelJob& job = *task.job;
+        std::exception_ptr error;
+        try {
+            (*job.func)(task.begin, task.end);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        // Notify in the lock, because the job is destructed after that.
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (error && !job.error) {
+            job.error = error;
+        }
+        if (--job.n_left == 0) {
+            job.cond.notify_all();
+        }
+    }
+
+    std::mutex m_config_mutex;
+    size_t m_n_worker = 0;
+    std::vector<size_t> m_cpus;
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<size_t> m_n_pending{0};
+    bool m_stopping = false;
+};
+
+ThreadPool& GetThreadPool() {
+    // Never destructed, so that workers are not joined at exit.
+    static ThreadPool* pool = new ThreadPool();
+    return *pool;
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace
+
+// ================================= Parallel ==================================
+void ParallelFor(size_t n,
+                 const std::function<void(size_t begin, size_t end)>& func,
+                 size_t n_worker) {
+    if (n_worker == 1 || n <= 1) {
+        func(0, n);
+        return;
+    }
+
+    ThreadPool& pool = GetThreadPool();
+    size_t n_task = n_worker;
+    if (n_worker == 0) {
+        // Finer tasks for load balancing
+        n_task = (pool.getWorkerCount() + 1) * 4;
+    }
+    pool.run(n, func, std::min(n, n_task));
+}
+
+void ParallelForPinned(
+        size_t n, const std::function<void(size_t begin, size_t end)>& func) {
+    ThreadPool& pool = GetThreadPool();
+    if (n <= 1 || !pool.isBound() || t_worker_idx != SIZE_MAX) {
+        // Nested calls are not pinned, because the worker of a range may be
+        // waiting for the caller.
+        ParallelFor(n, func);
+        return;
+    }
+    pool.run(n, func, pool.getWorkerCount(), true);
+}
+
+void SetParallelWorkers(size_t n_worker, const std::vector<size_t>& cpus) {
+    GetThreadPool().configure(n_worker, cpus);
+}
+
+size_t GetParallelWorkerCount() {
+    return GetThreadPool().getWorkerCount();
+}
+
+bool HasParallelAffinity() {
+    return GetThreadPool().isBound();
+}
+
+// -----------------------------------------------------------------------------
+
+}  // namespace oglw
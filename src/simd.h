@@ -0,0 +1,69 @@
+#ifndef SIMD_H_190520
+#define SIMD_H_190520
+
+// ==================================== SIMD ===================================
+// SSE2 kernels are always used on x86-64. AVX2 and F16C ones are compiled
+// with target attributes, and chosen at runtime by `UseAvx2()`/`UseF16c()`.
+#if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define OGLW_SIMD_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define OGLW_TARGET_AVX2
+#define OGLW_TARGET_F16C
+#define OGLW_SIMD_AVX2
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#define OGLW_TARGET_AVX2 __attribute__((target("avx2")))
+#define OGLW_TARGET_F16C __attribute__((target("avx,f16c")))
+#define OGLW_SIMD_AVX2
+#endif
+#endif
+
+namespace oglw {
+
+#if defined(OGLW_SIMD_AVX2)
+inline bool HasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                        (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_avx && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+inline bool HasF16c() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+           (info[2] & (1 << 29)) && (_xgetbv(0) & 6) == 6;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // AVX is checked for the OS support of YMM registers
+    return __builtin_cpu_supports("avx") && (ecx & bit_F16C);
+#endif
+}
+
+inline bool UseAvx2() {
+    static const bool USE_AVX2 = HasAvx2();
+    return USE_AVX2;
+}
+
+inline bool UseF16c() {
+    static const bool USE_F16C = HasF16c();
+    return USE_F16C;
+}
+#endif
+
+}  // namespace oglw
+
+#endif /* end of include guard */
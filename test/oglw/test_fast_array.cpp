@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 class Timer {
@@ -114,6 +115,179 @@ TEST_CASE("FastArray test") {
         }
     }
 
+    SECTION("Resize to smaller") {
+        oglw::FastArray<int> a(100);
+        for (size_t i = 0; i < a.size(); i++) {
+            a[i] = static_cast<int>(i);
+        }
+        a.resize(10);
+        REQUIRE(a.size() == 10);
+        REQUIRE(a.capacity() == 100);
+        for (size_t i = 0; i < a.size(); i++) {
+            REQUIRE(a[i] == static_cast<int>(i));
+        }
+        a.resize(0);
+        REQUIRE(a.empty());
+        a.clear();
+        REQUIRE(a.capacity() == 0);
+    }
+
+    SECTION("Reserve and push_back") {
+        oglw::FastArray<int> a;
+        a.reserve(10);
+        REQUIRE(a.size() == 0);
+        REQUIRE(a.capacity() == 10);
+        const int* head = a.data();
+        for (int i = 0; i < 10; i++) {
+            a.push_back(i);
+        }
+        REQUIRE(a.data() == head);  // No reallocation
+        for (int i = 10; i < 1000; i++) {
+            a.push_back(i);
+        }
+        REQUIRE(a.size() == 1000);
+        REQUIRE(1000 <= a.capacity());
+        for (size_t i = 0; i < a.size(); i++) {
+            REQUIRE(a[i] == static_cast<int>(i));
+        }
+        // Element of itself
+        a.resize(a.capacity());
+        a.push_back(a[0]);
+        REQUIRE(a[a.size() - 1] == 0);
+    }
+
+    SECTION("Append") {
+        const std::vector<int> v = {0, 1, 2, 3, 4};
+        oglw::FastArray<int> a;
+        a.append(v.begin(), v.end());
+        a.append(v.begin(), v.end());
+        REQUIRE(a.size() == 10);
+        for (size_t i = 0; i < a.size(); i++) {
+            REQUIRE(a[i] == static_cast<int>(i % 5));
+        }
+        // Range of itself
+        const oglw::FastArray<int>& c = a;
+        a.append(c.begin(), c.end());
+        REQUIRE(a.size() == 20);
+        for (size_t i = 0; i < a.size(); i++) {
+            REQUIRE(a[i] == static_cast<int>(i % 5));
+        }
+    }
+
+    SECTION("Alignment") {
+        for (size_t n = 1; n < 100; n++) {
+            oglw::FastArray<uint8_t> a(n);
+            REQUIRE(reinterpret_cast<uintptr_t>(a.data()) % 64 == 0);
+            oglw::FastArray<float, 16> b(n);
+            REQUIRE(reinterpret_cast<uintptr_t>(b.data()) % 16 == 0);
+            oglw::FastArray<float, 16> c = b;
+            REQUIRE(reinterpret_cast<uintptr_t>(c.data()) % 16 == 0);
+        }
+    }
+
+    SECTION("External memory") {
+        auto owner = std::make_shared<std::vector<float>>(100, 1.f);
+        oglw::FastArray<float, 4> a;
+        a.attach(owner->data(), 100, owner, true);
+        REQUIRE(a.isExternal());
+        REQUIRE(a.isReadOnly());
+        REQUIRE(a.data() == owner->data());
+        REQUIRE(owner.use_count() == 2);
+        // Copy to own memory
+        oglw::FastArray<float, 4> b = a;
+        REQUIRE(!b.isExternal());
+        REQUIRE(b[99] == 1.f);
+        // Move keeps the owner
+        oglw::FastArray<float, 4> c = std::move(a);
+        REQUIRE(c.isExternal());
+        REQUIRE(owner.use_count() == 2);
+        // Reallocation releases the owner
+        c.alloc(10);
+        REQUIRE(!c.isExternal());
+        REQUIRE(!c.isReadOnly());
+        REQUIRE(c.data() != owner->data());
+        REQUIRE(owner.use_count() == 1);
+    }
+
+    SECTION("Parallel fill and copy") {
+        const size_t N = oglw::FAST_ARRAY_PARALLEL_BYTES / sizeof(int) + 123;
+        oglw::FastArray<int> a(N, 7);
+        REQUIRE(std::all_of(a.begin(), a.end(), [](int v) { return v == 7; }));
+        for (size_t i = 0; i < N; i++) {
+            a[i] = static_cast<int>(i);
+        }
+        const oglw::FastArray<int> b = a;
+        bool same = true;
+        for (size_t i = 0; i < N; i++) {
+            same &= (b[i] == static_cast<int>(i));
+        }
+        REQUIRE(same);
+    }
+
+    SECTION("Memory pool") {
+        oglw::TrimMemoryPool();
+        oglw::ResetMemoryPoolStats();
+
+        const size_t N = 1024 * 1024;
+        { oglw::FastArray<float> a(N); }  // Miss
+        { oglw::FastArray<float> a(N); }  // Hit
+        { oglw::FastArray<float> a(N - 10); }  // Hit (same size class)
+        { oglw::FastArray<float> a(10); }  // Bypass
+        auto stats = oglw::GetMemoryPoolStats();
+        REQUIRE(stats.n_miss == 1);
+        REQUIRE(stats.n_hit == 2);
+        REQUIRE(stats.n_cached == 1);
+        REQUIRE(N * sizeof(float) <= stats.cached_bytes);
+
+        // Multi-thread
+        std::vector<std::thread> workers(4);
+        for (auto&& worker : workers) {
+            worker = std::thread([&]() {
+                for (size_t i = 0; i < 100; i++) {
+                    oglw::FastArray<float> a(N);
+                    a[N - 1] = 1.f;
+                }
+            });
+        }
+        for (auto&& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(oglw::GetMemoryPoolStats().n_miss <= 1 + workers.size());
+
+        oglw::TrimMemoryPool();
+        stats = oglw::GetMemoryPoolStats();
+        REQUIRE(stats.n_cached == 0);
+        REQUIRE(stats.cached_bytes == 0);
+    }
+
+    SECTION("Memory pool mapping") {
+        const size_t threshold = oglw::GetMemoryPoolMapThreshold();
+        oglw::SetMemoryPoolMapThreshold(1024 * 1024);
+        {
+            const size_t N = 1024 * 1024;
+            oglw::FastArray<float> a(N);
+            auto stats = oglw::GetMemoryPoolStats();
+            REQUIRE(stats.n_mapped == 1);
+            REQUIRE(N * sizeof(float) <= stats.mapped_bytes);
+            // Zero-filled lazily
+            REQUIRE(a[0] == 0.f);
+            REQUIRE(a[N - 1] == 0.f);
+            a.fill(1.f);
+            REQUIRE(a[N / 2] == 1.f);
+            // Returned to the OS
+            a.clear();
+            REQUIRE(oglw::GetMemoryPoolStats().n_mapped == 0);
+            REQUIRE(oglw::GetMemoryPoolStats().mapped_bytes == 0);
+        }
+        {
+            // Changing threshold after allocation
+            oglw::FastArray<float> a(1024 * 1024);
+            oglw::SetMemoryPoolMapThreshold(threshold);
+        }
+        REQUIRE(oglw::GetMemoryPoolStats().n_mapped == 0);
+        REQUIRE(oglw::GetMemoryPoolMapThreshold() == threshold);
+    }
+
     SECTION("Range-for") {
         oglw::FastArray<int> a(10);
         {
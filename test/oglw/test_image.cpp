@@ -2,12 +2,21 @@
 
 #include <oglw/gl_utils.h>
 #include <oglw/image.h>
+#include <oglw/image_transform.h>
 #include <oglw/image_utils.h>
 
 #include "gl_window.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -91,6 +100,43 @@ TEST_CASE("Image test") {
         REQUIRE(CheckAll(*img));
     }
 
+    SECTION("Float16 conversion") {
+        REQUIRE(sizeof(oglw::Float16) == 2);
+        // All finite values round-trip
+        bool ok = true;
+        for (uint32_t b = 0; b < 0x10000; b++) {
+            const auto h = oglw::Float16::FromBits(static_cast<uint16_t>(b));
+            const float f = static_cast<float>(h);
+            if ((b & 0x7c00) != 0x7c00) {
+                ok &= (oglw::Float16(f).bits == h.bits);
+            }
+        }
+        REQUIRE(ok);
+        // Round to nearest even
+        REQUIRE(oglw::Float16(1.f + 1.f / 2048.f).bits == 0x3c00);
+        REQUIRE(oglw::Float16(1.f + 3.f / 2048.f).bits == 0x3c02);
+        REQUIRE(oglw::Float16(65519.f).bits == 0x7bff);
+        REQUIRE(oglw::Float16(65520.f).bits == 0x7c00);
+        REQUIRE(oglw::Float16(-1e10f).bits == 0xfc00);
+        REQUIRE(oglw::Float16(1e-8f).bits == 0x0000);
+        REQUIRE(oglw::Float16(6e-8f).bits == 0x0001);  // Smallest subnormal
+        REQUIRE(static_cast<float>(oglw::Float16(0.1f)) ==
+                Approx(0.1f).epsilon(1e-3));
+        // Bulk conversion matches the scalar one
+        oglw::CpuImage<float> f_img(1001, 3, 1);
+        f_img.foreach ([](size_t x, size_t y, size_t, float& v) {
+            v = (static_cast<float>(x) - 500.f) * std::pow(10.f, y * 2.f - 2.f);
+        });
+        auto h_img = f_img.convertTo<oglw::Float16>();
+        auto f_img2 = h_img->convertTo<float>();
+        f_img.foreach ([&](size_t x, size_t y, size_t, const float& v) {
+            const oglw::Float16 h(v);
+            ok &= (h_img->at(x, y, 0).bits == h.bits);
+            ok &= (f_img2->at(x, y, 0) == static_cast<float>(h));
+        });
+        REQUIRE(ok);
+    }
+
     SECTION("CpuImage Basic float") {
         auto img = oglw::CpuImage<float>::Create(10, 20, 3);
         // Set
@@ -99,6 +145,41 @@ TEST_CASE("Image test") {
         REQUIRE(CheckAll(*img));
     }
 
+    SECTION("CpuImage Row alignment") {
+        oglw::CpuImage<uint8_t> img(10, 20, 3, 64);
+        REQUIRE(img.getRowStride() == 64 * 3);
+        for (size_t y = 0; y < img.getHeight(); y++) {
+            const auto addr = reinterpret_cast<uintptr_t>(&img.at(0, y, 0));
+            REQUIRE(addr % 64 == 0);
+        }
+        SetAll(img);
+        REQUIRE(CheckAll(img));
+
+        // Dense again
+        img.init(10, 20, 3);
+        REQUIRE(img.getRowStride() == 10 * 3);
+
+        // Invalid alignment
+        REQUIRE_THROWS(img.init(10, 20, 3, 3));
+    }
+
+    SECTION("CpuImage foreach with row alignment") {
+        auto img = oglw::CpuImage<float>::Create(7, 5, 3, 32);
+        REQUIRE(img->getRowStride() == 8 * 3);
+        img->foreach ([](size_t x, size_t y, size_t c, float& v) {
+            v = x + y + c;
+        });
+        REQUIRE(CheckAll(*img));
+        img->foreach (
+                [](size_t x, size_t y, float* vs) {
+                    for (size_t c = 0; c < 3; c++) {
+                        vs[c] = x + y + c;
+                    }
+                },
+                1);
+        REQUIRE(CheckAll(*img));
+    }
+
     SECTION("CpuImage Move-constructed") {
         oglw::CpuImage<uint8_t> img1(10, 20, 3);
         SetAll(img1);
@@ -157,6 +238,33 @@ TEST_CASE("Image test") {
         REQUIRE(CheckAll(img2));
     }
 
+    SECTION("CpuImage Copy-on-write") {
+        oglw::CpuImage<uint8_t> img1(10, 20, 3);
+        SetAll(img1);
+        const auto& img1_c = img1;
+
+        // Shared by copy
+        const auto img2 = img1;
+        REQUIRE(img1_c.data() == img2.data());
+        img1_c.foreach ([](size_t, size_t, size_t, const uint8_t&) {});
+        REQUIRE(img1_c.data() == img2.data());
+
+        // Cloned by mutable access
+        img1.at(3, 2, 1) = 45;
+        REQUIRE(img1_c.data() != img2.data());
+        REQUIRE(img1.at(3, 2, 1) == 45);
+        REQUIRE(CheckAll(img2));
+
+        // Shared by assignment
+        oglw::CpuImage<uint8_t> img3;
+        img3 = img2;
+        const auto& img3_c = img3;
+        REQUIRE(img3_c.data() == img2.data());
+        img3.init(5, 5, 1);
+        REQUIRE(img3_c.data() != img2.data());
+        REQUIRE(CheckAll(img2));
+    }
+
     SECTION("CpuImage foreach parallel") {
         // Non-const, Non-const
         auto img = oglw::CpuImage<uint8_t>::Create(10, 20, 3);
@@ -243,6 +351,285 @@ TEST_CASE("Image test") {
                 1);
     }
 
+    SECTION("CpuImage foreach std::function") {
+        auto img = oglw::CpuImage<float>::Create(10, 20, 3);
+        std::function<void(size_t, size_t, size_t, float&)> set_func =
+                [](size_t x, size_t y, size_t c, float& v) { v = x + y + c; };
+        img->foreach (set_func);
+        REQUIRE(CheckAll(*img));
+        std::function<void(size_t, size_t, const float*)> check_func =
+                [](size_t x, size_t y, const float* vs) {
+                    for (size_t c = 0; c < 3; c++) {
+                        REQUIRE(vs[c] == x + y + c);
+                    }
+                };
+        const oglw::CpuImage<float>& img2 = *img;
+        img2.foreach (check_func, 1);
+    }
+
+    SECTION("CpuImage foreach functor") {
+        struct Scale {
+            float s;
+            void operator()(size_t, size_t, size_t, float& v) const {
+                v *= s;
+            }
+        };
+        auto img = oglw::CpuImage<float>::Create(10, 20, 3);
+        SetAll(*img);
+        img->foreach (Scale{2.f});
+        img->foreach (Scale{0.5f}, 1);
+        REQUIRE(CheckAll(*img));
+    }
+
+    SECTION("CpuImage foreach tile") {
+        struct Shape {
+            size_t w, h, d;
+            oglw::ForeachTile tile;
+        };
+        const std::vector<Shape> shapes = {
+                {16384, 8, 1, {}},  {8, 16384, 4, {}}, {1000, 300, 3, {}},
+                {1000, 300, 3, {3, 5}}, {257, 129, 2, {1000, 1}},
+        };
+        for (auto&& s : shapes) {
+            oglw::CpuImage<float> img(s.w, s.h, s.d);
+            img.foreach ([](size_t, size_t, size_t, float& v) { v = 0.f; });
+            img.foreach ([](size_t x, size_t y, size_t c,
+                            float& v) { v += float(x + y + c); },
+                         0, s.tile);
+            REQUIRE(CheckAll(img));
+        }
+    }
+
+    SECTION("CpuImage foreach pinned") {
+        // Row bands on workers bound to CPUs, for large images
+        oglw::SetParallelWorkers(3, {0});
+        for (auto layout :
+             {oglw::ImageLayout::INTERLEAVED, oglw::ImageLayout::PLANAR}) {
+            oglw::CpuImage<float> img(1024, 1024, 4, 0, layout);
+            img.foreach ([](size_t, size_t, size_t, float& v) { v = 0.f; });
+            img.foreach ([](size_t x, size_t y, size_t c, float& v) {
+                v += float(x + y + c);
+            });
+            REQUIRE(CheckAll(img));
+            size_t n_row = 0;
+            img.foreachRow([&](size_t, size_t, float*) { n_row++; }, 1);
+            std::atomic<size_t> n_row_parallel(0);
+            img.foreachRow([&](size_t, size_t, float*) { n_row_parallel++; });
+            REQUIRE(n_row == n_row_parallel);
+        }
+        oglw::SetParallelWorkers(0);
+    }
+
+    SECTION("CpuImage View") {
+        oglw::CpuImage<uint8_t> img(10, 20, 3, 16);
+        SetAll(img);
+        auto view = img.view(2, 3, 5, 6);
+        REQUIRE(view.getWidth() == 5);
+        REQUIRE(view.getHeight() == 6);
+        REQUIRE(view.getDepth() == 3);
+        REQUIRE(view.getRowStride() == img.getRowStride());
+        REQUIRE(view.data() == &img.at(2, 3, 0));
+        REQUIRE(view.at(1, 2, 1) == 2 + 1 + 3 + 2 + 1);
+
+        // Write through the view
+        view.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 0; });
+        size_t n_zero = 0;
+        const oglw::CpuImage<uint8_t>& c_img = img;
+        c_img.foreach ([&](size_t, size_t, size_t, const uint8_t& v) {
+            n_zero += (v == 0);
+        }, 1);
+        REQUIRE(n_zero == 5 * 6 * 3 + 1);  // (0, 0, 0) is also zero
+
+        // Sub-view and const view
+        oglw::CpuImageView<const uint8_t> sub = view.view(1, 1, 2, 2);
+        REQUIRE(sub.data() == &img.at(3, 4, 0));
+        REQUIRE(c_img.view().data() == c_img.data());
+        REQUIRE_THROWS(view.view(4, 0, 2, 1));
+        REQUIRE_THROWS(view.view(~size_t(0), 0, 2, 1));  // Not wrapped
+        REQUIRE_THROWS(view.view(0, 1, 1, ~size_t(0)));
+        REQUIRE_THROWS(img.view(0, 19, 1, 2));
+
+        // Pixels are kept after the image is gone
+        {
+            oglw::CpuImage<uint8_t> img2(4, 4, 1);
+            SetAll(img2);
+            sub = img2.view(1, 1, 2, 2);
+        }
+        REQUIRE(sub.at(1, 1, 0) == 4);
+
+        // Views do not break copy-on-write of copies made before
+        oglw::CpuImage<uint8_t> copied = img;
+        img.view().at(0, 0, 1) = 99;
+        REQUIRE(copied.at(0, 0, 1) == 1);
+
+        // Copies made after a mutable view have their own pixels
+        auto view2 = img.view();
+        const oglw::CpuImage<uint8_t> copied2 = img;
+        view2.at(0, 0, 2) = 77;
+        REQUIRE(copied2.at(0, 0, 2) == 2);
+        REQUIRE(c_img.at(0, 0, 2) == 77);
+    }
+
+    SECTION("CpuImage Dirty regions") {
+        oglw::CpuImage<uint8_t> img(200, 150, 3);
+        REQUIRE(img.isDirty());
+        REQUIRE(img.getDirtyRects().size() == 1);
+        REQUIRE(img.getDirtyRects()[0].w == 200);
+        img.clearDirty();
+        REQUIRE(!img.isDirty());
+
+        // Tiles of written pixels
+        img.at(70, 10, 0) = 1;
+        auto rects = img.getDirtyRects();
+        REQUIRE(rects.size() == 1);
+        REQUIRE(rects[0].x == 64);
+        REQUIRE(rects[0].y == 0);
+        REQUIRE(rects[0].w == 64);
+        REQUIRE(rects[0].h == 64);
+
+        // Merged horizontally and vertically, clamped to the image
+        img.markDirty(100, 100, 100, 50);
+        rects = img.getDirtyRects();
+        REQUIRE(rects.size() == 2);
+        REQUIRE(rects[1].x == 64);
+        REQUIRE(rects[1].y == 64);
+        REQUIRE(rects[1].w == 200 - 64);
+        REQUIRE(rects[1].h == 150 - 64);
+        img.markDirty(64, 50, 1, 1);
+        rects = img.getDirtyRects();
+        REQUIRE(rects.size() == 2);
+        REQUIRE(rects[0].h == 64);
+
+        // Sub-views mark their tiles, and const accesses nothing
+        img.clearDirty();
+        img.view(100, 100, 10, 10);
+        rects = img.getDirtyRects();
+        REQUIRE(rects.size() == 1);
+        REQUIRE(rects[0].x == 64);
+        REQUIRE(rects[0].y == 64);
+        img.clearDirty();
+        const oglw::CpuImage<uint8_t>& c_img = img;
+        c_img.at(0, 0, 0);
+        c_img.view();
+        c_img.data();
+        REQUIRE(!img.isDirty());
+        img.data();
+        REQUIRE(img.getDirtyRects()[0].h == 150);
+
+        // Marked from threads at once, and copied with the pixels
+        img.clearDirty();
+        std::thread th([&]() {
+            for (size_t x = 0; x < 64; x++) {
+                img.at(x, 0, 0) = 1;
+            }
+        });
+        for (size_t x = 0; x < 64; x++) {
+            img.at(x, 149, 0) = 1;
+        }
+        th.join();
+        oglw::CpuImage<uint8_t> img2 = img;
+        rects = img2.getDirtyRects();
+        REQUIRE(rects.size() == 2);
+        REQUIRE(rects[0].y == 0);
+        REQUIRE(rects[1].y == 128);
+    }
+
+    SECTION("CpuImage Planar layout") {
+        oglw::CpuImage<uint8_t> img(10, 20, 3, 16, oglw::ImageLayout::PLANAR);
+        REQUIRE(img.getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(img.getRowStride() == 16);
+        SetAll(img);
+        REQUIRE(CheckAll(img));
+        REQUIRE(img.data()[(2 * 20 + 3) * 16 + 4] == 3 + 4 + 2);
+
+        // Rearrange both ways
+        oglw::CpuImage<uint8_t> interleaved = img;
+        interleaved.setLayout(oglw::ImageLayout::INTERLEAVED);
+        REQUIRE(interleaved.getRowStride() == 16 * 3);
+        REQUIRE(CheckAll(interleaved));
+        REQUIRE(img.getLayout() == oglw::ImageLayout::PLANAR);
+        oglw::CpuImage<uint8_t> img2(100, 120, 4);
+        SetAll(img2);
+        img2.setLayout(oglw::ImageLayout::PLANAR);
+        REQUIRE(CheckAll(img2));
+        img2.setLayout(oglw::ImageLayout::INTERLEAVED);
+        REQUIRE(CheckAllByPtr(img2));
+
+        // foreach by value and by row
+        img.foreach ([](size_t x, size_t y, size_t z, uint8_t& v) {
+            v = static_cast<uint8_t>(v - x - y - z + 1);
+        });
+        size_t n_one = 0;
+        const oglw::CpuImage<uint8_t>& c_img = img;
+        c_img.foreachRow([&](size_t, size_t, const uint8_t* row) {
+            n_one += static_cast<size_t>(std::count(row, row + 10, 1));
+        }, 1);
+        REQUIRE(n_one == 10 * 20 * 3);
+        REQUIRE_THROWS(img.foreach ([](size_t, size_t, uint8_t*) {}));
+        REQUIRE_THROWS(img.view());
+        size_t n_row = 0;
+        interleaved.foreachRow([&](size_t, size_t z, uint8_t*) {
+            n_row += (z == 0);
+        }, 1);
+        REQUIRE(n_row == 20);
+
+        // Conversion keeps the layout, and saving interleaves
+        auto f_img = interleaved.convertTo<float>();
+        f_img->setLayout(oglw::ImageLayout::PLANAR);
+        auto u16_img = f_img->convertTo<uint16_t>();
+        REQUIRE(u16_img->getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(CheckAll(*u16_img));
+        u16_img->save("test_cpuimg_planar.raw");
+        std::ifstream ifs("test_cpuimg_planar.raw", std::ios::binary);
+        std::vector<uint16_t> raw(10 * 20 * 3);
+        ifs.read(reinterpret_cast<char*>(raw.data()), 10 * 20 * 3 * 2);
+        REQUIRE(raw[3 * 10 * 3 + 4 * 3 + 2] == 3 + 4 + 2);
+    }
+
+    SECTION("CpuImage convertTo") {
+        // Odd width for the tails of SIMD kernels, and large for threads
+        for (size_t w : {37u, 1025u}) {
+            oglw::CpuImage<uint8_t> u8_img(w, 300, 3, 64);
+            u8_img.foreach ([](size_t x, size_t y, size_t c, uint8_t& v) {
+                v = static_cast<uint8_t>(x * 7 + y * 3 + c);
+            });
+            // uint8_t -> float
+            auto f_img = u8_img.convertTo<float>(1.f / 255.f);
+            REQUIRE(f_img->getWidth() == w);
+            REQUIRE(f_img->getRowStride() == w * 3);
+            bool ok = true;
+            f_img->foreach ([&](size_t x, size_t y, size_t c, const float& v) {
+                const float expected = u8_img.at(x, y, c) * (1.f / 255.f);
+                ok &= (std::abs(v - expected) < 1e-6f);
+            }, 1);
+            REQUIRE(ok);
+            // float -> Float16 -> uint8_t (rounded)
+            auto u8_img2 = f_img->convertTo<oglw::Float16>()
+                                   ->convertTo<uint8_t>(255.f);
+            u8_img2->foreach ([&](size_t x, size_t y, size_t c,
+                                  const uint8_t& v) {
+                ok &= (v == u8_img.at(x, y, c));
+            }, 1);
+            REQUIRE(ok);
+        }
+        // Clamp
+        oglw::CpuImage<float> f_img(40, 1, 1);
+        f_img.foreach ([](size_t x, size_t, size_t, float& v) {
+            v = static_cast<float>(x) * 20.f - 300.f;
+        });
+        auto u8_img = f_img.convertTo<uint8_t>(1.f, 0.4f);
+        for (size_t x = 0; x < 40; x++) {
+            const float v = static_cast<float>(x) * 20.f - 300.f + 0.4f;
+            REQUIRE(u8_img->at(x, 0, 0) ==
+                    std::min(std::max(std::round(v), 0.f), 255.f));
+        }
+        auto u8_img3 = u8_img->convertTo<uint8_t>(2.f, -10.f);
+        for (size_t x = 0; x < 40; x++) {
+            const float v = u8_img->at(x, 0, 0) * 2.f - 10.f;
+            REQUIRE(u8_img3->at(x, 0, 0) == std::min(std::max(v, 0.f), 255.f));
+        }
+    }
+
     SECTION("CpuImage Load and Save") {
         oglw::GlWindow win("Title");
         auto cpu_img = oglw::CpuImage<float>::Create();
@@ -250,6 +637,218 @@ TEST_CASE("Image test") {
         cpu_img->save("test_cpuimg_save.jpg");
     }
 
+    SECTION("CpuImage Load 16-bit") {
+        // 16x8 RGB, value of file row `r` is `(x * 4099 + r * 257 + c * 1000)`
+        oglw::CpuImage<uint16_t> u16_img;
+        oglw::CpuImage<float> f_img;
+        u16_img.load("../data/gradient16.png");
+        f_img.load("../data/gradient16.png");
+        REQUIRE(u16_img.getWidth() == 16);
+        REQUIRE(u16_img.getHeight() == 8);
+        REQUIRE(u16_img.getDepth() == 3);
+        bool ok = true;
+        u16_img.foreach ([&](size_t x, size_t y, size_t c, const uint16_t& v) {
+            const size_t r = 7 - y;  // y-flip
+            const size_t expected = (x * 4099 + r * 257 + c * 1000) % 65536;
+            ok &= (v == expected);
+            ok &= std::abs(f_img.at(x, y, c) - expected / 65535.f) < 1e-6f;
+        });
+        REQUIRE(ok);
+        // To 8-bit
+        auto u8_img = u16_img.convertTo<uint8_t>(255.f / 65535.f);
+        REQUIRE(u8_img->at(15, 7, 2) == std::round(u16_img.at(15, 7, 2) /
+                                                   257.f));
+    }
+
+    SECTION("CpuImage Load HDR") {
+        // 7x4 RGBE, mantissa `(x * 31 + r * 7 + c * 50) % 256` and exponent
+        // `r * 3 - 4`
+        oglw::CpuImage<float> f_img;
+        oglw::CpuImage<oglw::Float16> h_img;
+        f_img.load("../data/gradient.hdr");
+        h_img.load("../data/gradient.hdr");
+        REQUIRE(f_img.getWidth() == 7);
+        REQUIRE(f_img.getHeight() == 4);
+        bool ok = true;
+        f_img.foreach ([&](size_t x, size_t y, size_t c, const float& v) {
+            const size_t r = 3 - y;  // y-flip
+            const float m = static_cast<float>((x * 31 + r * 7 + c * 50) % 256);
+            const float expected = std::ldexp(m, static_cast<int>(r * 3) - 12);
+            ok &= (v == expected);
+            ok &= (h_img.at(x, y, c) == oglw::Float16(expected));
+        });
+        REQUIRE(ok);
+    }
+
+    SECTION("CpuImage Save formats") {
+        // PNG is lossless
+        oglw::CpuImage<uint8_t> u8_img(13, 7, 3);
+        SetAll(u8_img);
+        oglw::ImageSaveOptions options;
+        options.png_compression = 1;
+        u8_img.save("test_cpuimg_save.png", options);
+        oglw::CpuImage<uint8_t> u8_img2;
+        u8_img2.load("test_cpuimg_save.png");
+        REQUIRE(CheckAll(u8_img2));
+        // Format by options
+        options.format = oglw::ImageFormat::BMP;
+        u8_img.save("test_cpuimg_save_bmp.img", options);
+        u8_img.save("test_cpuimg_save.TGA");
+
+        // PFM (bottom-to-top)
+        oglw::CpuImage<float> f_img(5, 4, 3);
+        SetAll(f_img);
+        f_img.save("test_cpuimg_save.pfm");
+        std::ifstream pfm("test_cpuimg_save.pfm", std::ios::binary);
+        std::string magic;
+        size_t w = 0, h = 0;
+        float endian = 0.f;
+        pfm >> magic >> w >> h >> endian;
+        pfm.get();  // Single white space
+        REQUIRE(magic == "PF");
+        REQUIRE(w == 5);
+        REQUIRE(h == 4);
+        std::vector<float> pfm_data(5 * 4 * 3);
+        pfm.read(reinterpret_cast<char*>(pfm_data.data()),
+                 static_cast<std::streamsize>(pfm_data.size() * 4));
+        REQUIRE(pfm);
+        REQUIRE(std::memcmp(pfm_data.data(), f_img.data(),
+                            pfm_data.size() * 4) == 0);
+        oglw::CpuImage<float> f4_img(5, 4, 4);
+        REQUIRE_THROWS(f4_img.save("test_cpuimg_save_4ch.pfm"));
+
+        // Raw without padding
+        oglw::CpuImage<uint16_t> u16_img(5, 4, 3, 64);
+        SetAll(u16_img);
+        u16_img.save("test_cpuimg_save.raw");
+        std::ifstream raw("test_cpuimg_save.raw", std::ios::binary);
+        std::vector<uint16_t> raw_data(5 * 4 * 3 + 1);
+        raw.read(reinterpret_cast<char*>(raw_data.data()),
+                 static_cast<std::streamsize>(raw_data.size() * 2));
+        REQUIRE(raw.gcount() == 5 * 4 * 3 * 2);
+        bool ok = true;
+        for (size_t i = 0; i < 5 * 4 * 3; i++) {
+            ok &= (raw_data[i] == u16_img.at(i / 3 % 5, i / 15, i % 3));
+        }
+        REQUIRE(ok);
+    }
+
+    SECTION("CpuImage Native format") {
+        oglw::CpuImage<float> f_img(33, 17, 3, 64);
+        SetAll(f_img);
+        f_img.save("test_cpuimg_save.oglw");
+        // Mapped with copy-on-write
+        oglw::CpuImage<float> f_img2;
+        f_img2.load("test_cpuimg_save.oglw");
+        REQUIRE(f_img2.getWidth() == 33);
+        REQUIRE(f_img2.getRowStride() == f_img.getRowStride());
+        REQUIRE(reinterpret_cast<uintptr_t>(f_img2.data()) % 64 == 0);
+        REQUIRE(CheckAll(f_img2));
+        f_img2.at(0, 0, 0) = 100.f;
+        // Read-only
+        oglw::CpuImage<float> f_img3;
+        f_img3.map("test_cpuimg_save.oglw");
+        const auto& c_img3 = f_img3;
+        const float* mapped = c_img3.data();
+        REQUIRE(CheckAll(c_img3));  // The file is not modified
+        REQUIRE(c_img3.data() == mapped);
+        f_img3.at(1, 0, 0) = 200.f;  // Cloned
+        REQUIRE(f_img3.data() != mapped);
+        REQUIRE(f_img3.at(1, 0, 0) == 200.f);
+        // Converted
+        oglw::CpuImage<uint8_t> u8_img;
+        u8_img.load("test_cpuimg_save.oglw");
+        REQUIRE(u8_img.at(10, 5, 2) == 255);
+        REQUIRE(u8_img.at(0, 0, 0) == 0);
+        REQUIRE_THROWS(u8_img.map("test_cpuimg_save.oglw"));
+        REQUIRE_THROWS(u8_img.map("../data/lena.jpg"));
+
+        // Broken headers
+        std::ifstream ifs("test_cpuimg_save.oglw", std::ios::binary);
+        const std::vector<char> bytes((std::istreambuf_iterator<char>(ifs)),
+                                      std::istreambuf_iterator<char>());
+        auto write_broken = [&](size_t n_byte, size_t field, uint64_t v) {
+            std::vector<char> broken(bytes.data(), bytes.data() + n_byte);
+            std::memcpy(broken.data() + field, &v, sizeof(v));
+            std::ofstream ofs("test_cpuimg_broken.oglw", std::ios::binary);
+            ofs.write(broken.data(), static_cast<std::streamsize>(n_byte));
+        };
+        const size_t HEIGHT = 24, DEPTH = 32, ROW_STRIDE = 40;
+        const uint64_t stride = f_img.getRowStride();
+        write_broken(bytes.size() - 4, HEIGHT, 17);  // Truncated
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        // `stride * height * 4` wraps around to 0 (stride of 64 bytes)
+        write_broken(bytes.size(), HEIGHT, uint64_t(1) << 58);
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        REQUIRE_THROWS(f_img3.map("test_cpuimg_broken.oglw"));
+        write_broken(bytes.size(), ROW_STRIDE, ~uint64_t(0) / 3 * 3);
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        write_broken(bytes.size(), ROW_STRIDE, stride - 2);  // Not pixels
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        write_broken(bytes.size(), DEPTH, 0);
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        write_broken(bytes.size(), DEPTH, 5);
+        REQUIRE_THROWS(f_img2.load("test_cpuimg_broken.oglw"));
+        write_broken(bytes.size(), HEIGHT, 17);  // Intact
+        f_img2.load("test_cpuimg_broken.oglw");
+        REQUIRE(CheckAll(f_img2));
+    }
+
+    SECTION("CpuImage Load types") {
+        oglw::CpuImage<uint8_t> u8_img;
+        oglw::CpuImage<float> f_img;
+        oglw::CpuImage<oglw::Float16> h_img;
+        u8_img.load("../data/lena.jpg");
+        f_img.load("../data/lena.jpg");
+        h_img.load("../data/lena.jpg");
+        h_img.load("../data/lena.jpg");  // Reuse
+        REQUIRE(f_img.getWidth() == u8_img.getWidth());
+        REQUIRE(h_img.getHeight() == u8_img.getHeight());
+        bool ok = true;
+        u8_img.foreach ([&](size_t x, size_t y, size_t c, const uint8_t& v) {
+            const float expected = v / 255.f;
+            ok &= std::abs(f_img.at(x, y, c) - expected) < 1e-6f;
+            ok &= std::abs(static_cast<float>(h_img.at(x, y, c)) - expected) <
+                  1e-3f;
+        }, 1);
+        REQUIRE(ok);
+    }
+
+    SECTION("CpuImage Load batch") {
+        std::vector<std::string> filenames;
+        for (size_t i = 0; i < 12; i++) {
+            filenames.push_back((i % 2 == 0) ? "../data/lena.jpg"
+                                             : "../data/gradient16.png");
+        }
+        filenames[5] = "../data/not_exist.png";
+        oglw::CpuImage<uint16_t> ref0, ref1;
+        ref0.load(filenames[0]);
+        ref1.load(filenames[1]);
+        for (size_t n_worker : {0u, 1u, 3u}) {
+            std::vector<std::string> errors;
+            auto images = oglw::LoadImages<uint16_t>(filenames, &errors,
+                                                     n_worker);
+            REQUIRE(images.size() == filenames.size());
+            REQUIRE(errors.size() == filenames.size());
+            REQUIRE(!images[5]);
+            REQUIRE(!errors[5].empty());
+            for (size_t i = 0; i < images.size(); i++) {
+                if (i == 5) {
+                    continue;
+                }
+                REQUIRE(errors[i].empty());
+                const auto& ref = (i % 2 == 0) ? ref0 : ref1;
+                const auto& img = *images[i];
+                REQUIRE(img.getWidth() == ref.getWidth());
+                REQUIRE(std::equal(ref.data(),
+                                   ref.data() + ref.getRowStride() *
+                                                        ref.getHeight(),
+                                   img.data()));
+            }
+        }
+        REQUIRE(oglw::LoadImages<float>({}).empty());
+    }
+
     // =============================================================================
     SECTION("GpuImage Basic 1ch") {
         oglw::GlWindow win("Title");
@@ -289,6 +888,24 @@ TEST_CASE("Image test") {
         REQUIRE(CheckAll(*cpu_img2));
     }
 
+    SECTION("GpuImage Row alignment") {
+        oglw::GlWindow win("Title");
+        auto cpu_img1 = oglw::CpuImage<uint8_t>::Create(10, 20, 3, 64);
+        SetAll(*cpu_img1);
+        oglw::GpuImagePtr<uint8_t> gpu_img = cpu_img1->toGpu();
+        oglw::CpuImagePtr<uint8_t> cpu_img2 = gpu_img->toCpu();
+        REQUIRE(CheckAll(*cpu_img2));
+    }
+
+    SECTION("GpuImage uint16") {
+        oglw::GlWindow win("Title");
+        auto cpu_img1 = oglw::CpuImage<uint16_t>::Create(10, 20, 4);
+        SetAll(*cpu_img1);
+        oglw::GpuImagePtr<uint16_t> gpu_img = cpu_img1->toGpu();
+        oglw::CpuImagePtr<uint16_t> cpu_img2 = gpu_img->toCpu();
+        REQUIRE(CheckAll(*cpu_img2));
+    }
+
     SECTION("GpuImage float16") {
         oglw::GlWindow win("Title");
         auto cpu_img1 = oglw::CpuImage<oglw::Float16>::Create(10, 20, 4);
@@ -306,4 +923,285 @@ TEST_CASE("Image test") {
         oglw::CpuImagePtr<float> cpu_img2 = gpu_img->toCpu();
         REQUIRE(CheckAll(*cpu_img2));
     }
+
+    SECTION("GpuImage View") {
+        oglw::GlWindow win("Title");
+        oglw::CpuImage<uint8_t> cpu_img1(10, 20, 3);
+        SetAll(cpu_img1);
+        oglw::GpuImagePtr<uint8_t> gpu_img = cpu_img1.view(2, 3, 5, 6).toGpu();
+        oglw::CpuImagePtr<uint8_t> cpu_img2 = gpu_img->toCpu();
+        REQUIRE(cpu_img2->getWidth() == 5);
+        REQUIRE(cpu_img2->at(4, 5, 2) == 2 + 4 + 3 + 5 + 2);
+
+        // Partial update
+        oglw::CpuImage<uint8_t> cpu_img3(2, 2, 3);
+        cpu_img3.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 0; });
+        gpu_img->fromCpu(cpu_img3.view(), 3, 4);
+        cpu_img2 = gpu_img->toCpu();
+        REQUIRE(cpu_img2->at(3, 4, 0) == 0);
+        REQUIRE(cpu_img2->at(4, 5, 2) == 0);
+        REQUIRE(cpu_img2->at(2, 5, 2) == 2 + 2 + 3 + 5 + 2);
+        REQUIRE_THROWS(gpu_img->fromCpu(cpu_img3.view(), 4, 4));
+    }
+
+    SECTION("GpuImage Mipmaps") {
+        oglw::GlWindow win("Title");
+        oglw::CpuImage<uint8_t> cpu_img1(16, 6, 4);
+        cpu_img1.foreach ([](size_t, size_t, size_t z, uint8_t& v) {
+            v = static_cast<uint8_t>(z * 50 + 10);
+        });
+        auto gpu_img = oglw::GpuImage<uint8_t>::Create();
+        gpu_img->fromCpu(oglw::BuildMipmaps(cpu_img1));
+        REQUIRE(gpu_img->getLevelCount() == 5);
+        auto cpu_img2 = gpu_img->toCpu(4);
+        REQUIRE(cpu_img2->getWidth() == 1);
+        REQUIRE(cpu_img2->at(0, 0, 3) == 160);
+        REQUIRE_THROWS(gpu_img->toCpu(5));
+
+        // Copies keep levels and sampling
+        gpu_img->setFilter(oglw::TextureFilter::NEAREST_MIPMAP_NEAREST,
+                           oglw::TextureFilter::NEAREST);
+        gpu_img->setLevelRange(1, 10);
+        oglw::GpuImage<uint8_t> gpu_img2 = *gpu_img;
+        REQUIRE(gpu_img2.getLevelCount() == 5);
+        REQUIRE(gpu_img2.toCpu(2)->at(3, 0, 1) == 60);
+        REQUIRE_THROWS(gpu_img->setFilter(
+                oglw::TextureFilter::LINEAR,
+                oglw::TextureFilter::LINEAR_MIPMAP_LINEAR));
+
+        // By the driver
+        oglw::GpuImage<uint8_t> gpu_img3(16, 6, 4, 0);
+        REQUIRE(gpu_img3.getLevelCount() == 5);
+        gpu_img3.fromCpu(cpu_img1);
+        gpu_img3.generateMipmaps();
+        REQUIRE(gpu_img3.toCpu(3)->at(1, 0, 2) == 110);
+        // Reallocation keeps mipmaps
+        gpu_img3.fromCpu(oglw::CpuImage<uint8_t>(4, 4, 4));
+        REQUIRE(gpu_img3.getLevelCount() == 3);
+
+        std::vector<oglw::CpuImagePtr<uint8_t>> invalid_levels = {
+                oglw::CpuImage<uint8_t>::Create(cpu_img1),
+                oglw::CpuImage<uint8_t>::Create(3, 3, 4)};
+        REQUIRE_THROWS(gpu_img->fromCpu(invalid_levels));
+    }
+
+    SECTION("GpuImage Async readback") {
+        oglw::GlWindow win("Title");
+        oglw::GpuImage<uint8_t> gpu_img;
+        REQUIRE(gpu_img.toCpuAsync().ready());
+        REQUIRE(!gpu_img.toCpuAsync().get());
+
+        // More frames than the ring of buffers
+        std::vector<oglw::GpuReadback<uint8_t>> readbacks;
+        for (size_t i = 0; i < 7; i++) {
+            oglw::CpuImage<uint8_t> cpu_img(13, 7, 3);
+            cpu_img.foreach ([&](size_t x, size_t y, size_t z, uint8_t& v) {
+                v = static_cast<uint8_t>(x + y * 13 + z + i * 20);
+            });
+            gpu_img.fromCpu(cpu_img);
+            readbacks.push_back(gpu_img.toCpuAsync());
+        }
+        for (size_t i = 0; i < readbacks.size(); i++) {
+            auto cpu_img = readbacks[i].get();
+            REQUIRE(readbacks[i].ready());
+            REQUIRE(cpu_img == readbacks[i].get());
+            REQUIRE(cpu_img->getWidth() == 13);
+            REQUIRE(cpu_img->at(12, 6, 2) == 12 + 6 * 13 + 2 + i * 20);
+        }
+
+        // Mip level, and the image released before the readback
+        oglw::GpuReadback<float> level_readback;
+        {
+            oglw::CpuImage<float> cpu_img(8, 4, 1);
+            cpu_img.foreach ([](size_t, size_t, size_t, float& v) {
+                v = 0.5f;
+            });
+            oglw::GpuImage<float> mip_img;
+            mip_img.fromCpu(oglw::BuildMipmaps(cpu_img));
+            level_readback = mip_img.toCpuAsync(2);
+            REQUIRE_THROWS(mip_img.toCpuAsync(4));
+        }
+        auto level_img = level_readback.get();
+        REQUIRE(level_img->getWidth() == 2);
+        REQUIRE(level_img->getHeight() == 1);
+        REQUIRE(level_img->at(1, 0, 0) == 0.5f);
+    }
+
+    SECTION("GpuImage Upload ring") {
+        oglw::GlWindow win("Title");
+        oglw::GpuUploadRing<uint8_t> ring(64 * 48 * 3, 2);
+        REQUIRE(ring.getSlotCount() == 2);
+        REQUIRE(64 * 48 * 3 <= ring.getSlotBytes());
+        oglw::GpuImage<uint8_t> gpu_img(64, 48, 3);
+
+        // Filled by workers, more frames than slots
+        for (size_t i = 0; i < 5; i++) {
+            auto slot = ring.acquire(64, 48, 3);
+            slot.foreach ([&](size_t x, size_t y, size_t z, uint8_t& v) {
+                v = static_cast<uint8_t>(x + y + z + i);
+            });
+            ring.commit(slot, gpu_img);
+            auto cpu_img = gpu_img.toCpu();
+            REQUIRE(cpu_img->at(63, 47, 2) == 63 + 47 + 2 + i);
+        }
+
+        // Partial and from a padded image
+        oglw::CpuImage<uint8_t> cpu_img1(10, 5, 3, 64);
+        SetAll(cpu_img1);
+        ring.upload(cpu_img1.view(), gpu_img, 3, 4);
+        auto cpu_img2 = gpu_img.toCpu();
+        REQUIRE(cpu_img2->at(3 + 9, 4 + 4, 2) == cpu_img1.at(9, 4, 2));
+        REQUIRE(cpu_img2->at(2, 4, 0) == 2 + 4 + 0 + 4);
+
+        // Converted from another type into a float texture
+        oglw::GpuUploadRing<float> f_ring(20 * 10 * 3 * sizeof(float), 1);
+        oglw::GpuImage<float> f_gpu_img(20, 10, 3);
+        const oglw::CpuImage<uint8_t> cpu_img3 = cpu_img1;
+        f_ring.upload(cpu_img3.view(), f_gpu_img, 10, 5, 0, 1.f / 255.f);
+        auto f_cpu_img = f_gpu_img.toCpu();
+        REQUIRE(f_cpu_img->at(10 + 9, 5 + 4, 2) ==
+                Approx(cpu_img3.at(9, 4, 2) / 255.f));
+        REQUIRE(f_cpu_img->at(10, 5, 0) ==
+                Approx(cpu_img3.at(0, 0, 0) / 255.f));
+
+        auto slot1 = ring.acquire(4, 4, 3);
+        auto slot2 = ring.acquire(4, 4, 3);
+        REQUIRE_THROWS(ring.acquire(4, 4, 3));  // All acquired
+        REQUIRE_THROWS(ring.commit(slot1, gpu_img, 61, 0));
+        REQUIRE_THROWS(ring.commit(cpu_img1.view(), gpu_img));
+        ring.commit(slot1.view(1, 1, 2, 2), gpu_img);
+        ring.commit(slot2, gpu_img);
+        REQUIRE_THROWS(ring.commit(slot2, gpu_img));  // Already committed
+        REQUIRE_THROWS(ring.acquire(100, 100, 3));
+    }
+
+    SECTION("GpuImage Dirty upload") {
+        oglw::GlWindow win("Title");
+        oglw::CpuImage<uint8_t> cpu_img(200, 150, 3);
+        SetAll(cpu_img);
+        oglw::GpuImage<uint8_t> gpu_img;
+        gpu_img.fromCpu(cpu_img);
+        REQUIRE(!cpu_img.isDirty());
+
+        // Untracked write is left, which shows the upload is partial
+        uint8_t* untracked = cpu_img.data();
+        gpu_img.fromCpu(cpu_img);
+        untracked[(10 * 200 + 10) * 3] = 200;
+        cpu_img.at(150, 120, 1) = 100;
+        gpu_img.fromCpu(cpu_img);
+        auto cpu_img2 = gpu_img.toCpu();
+        REQUIRE(cpu_img2->at(150, 120, 1) == 100);
+        REQUIRE(cpu_img2->at(10, 10, 0) == 10 + 10 + 0);
+
+        // Full upload after marking, or for other images
+        cpu_img.markDirty();
+        gpu_img.fromCpu(cpu_img);
+        REQUIRE(gpu_img.toCpu()->at(10, 10, 0) == 200);
+
+        // Const images are uploaded entirely, keeping their state
+        untracked[(10 * 200 + 10) * 3] = 201;
+        const oglw::CpuImage<uint8_t>& c_cpu_img = cpu_img;
+        gpu_img.fromCpu(c_cpu_img);
+        REQUIRE(gpu_img.toCpu()->at(10, 10, 0) == 201);
+        REQUIRE(!cpu_img.isDirty());
+        untracked[(10 * 200 + 10) * 3] = 202;
+        gpu_img.fromCpu(cpu_img);  // Not synced by the const upload
+        REQUIRE(gpu_img.toCpu()->at(10, 10, 0) == 202);
+        oglw::CpuImage<uint8_t> cpu_img3(200, 150, 3);
+        SetAll(cpu_img3);
+        cpu_img3.clearDirty();
+        gpu_img.fromCpu(cpu_img3);
+        REQUIRE(gpu_img.toCpu()->at(10, 10, 0) == 10 + 10 + 0);
+
+        // Planar images are interleaved before uploading the regions
+        cpu_img3.setLayout(oglw::ImageLayout::PLANAR);
+        gpu_img.fromCpu(cpu_img3);
+        cpu_img3.at(199, 149, 2) = 7;
+        gpu_img.fromCpu(cpu_img3);
+        auto cpu_img4 = gpu_img.toCpu();
+        REQUIRE(cpu_img4->at(199, 149, 2) == 7);
+        REQUIRE(cpu_img4->at(199, 149, 1) == cpu_img3.at(199, 149, 1));
+        REQUIRE(cpu_img4->at(1, 2, 1) == 1 + 2 + 1);
+    }
+
+    SECTION("GpuImage Array") {
+        oglw::GlWindow win("Title");
+        oglw::GpuImageArray<uint8_t> gpu_arr(16, 8, 3, 4);
+        REQUIRE(gpu_arr.getLayerCount() == 4);
+        REQUIRE(gpu_arr.getLevelCount() == 1);
+        oglw::CpuImage<uint8_t> cpu_img1(16, 8, 3);
+        SetAll(cpu_img1);
+        gpu_arr.fromCpu(2, cpu_img1);
+        REQUIRE(CheckAll(*gpu_arr.toCpu(2)));
+
+        // Partial update of a layer leaves the others
+        oglw::CpuImage<uint8_t> cpu_img2(4, 2, 3, 0,
+                                         oglw::ImageLayout::PLANAR);
+        cpu_img2.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 99; });
+        cpu_img2.setLayout(oglw::ImageLayout::INTERLEAVED);
+        gpu_arr.fromCpu(3, cpu_img2.view(), 5, 6);
+        REQUIRE(gpu_arr.toCpu(3)->at(8, 7, 2) == 99);
+        REQUIRE(CheckAll(*gpu_arr.toCpu(2)));
+        REQUIRE_THROWS(gpu_arr.fromCpu(4, cpu_img1));
+        REQUIRE_THROWS(gpu_arr.fromCpu(0, cpu_img2));
+        REQUIRE_THROWS(gpu_arr.fromCpu(0, cpu_img2.view(), 13, 0));
+        REQUIRE_THROWS(gpu_arr.toCpu(4));
+
+        // Copy, and all layers with mipmaps
+        oglw::GpuImageArray<uint8_t> copied = gpu_arr;
+        REQUIRE(copied.getTextureId() != gpu_arr.getTextureId());
+        REQUIRE(CheckAll(*copied.toCpu(2)));
+        std::vector<oglw::CpuImagePtr<uint8_t>> layers;
+        for (size_t i = 0; i < 3; i++) {
+            layers.push_back(oglw::CpuImage<uint8_t>::Create(8, 8, 1));
+            layers.back()->foreach ([&](size_t, size_t, size_t, uint8_t& v) {
+                v = static_cast<uint8_t>(i * 10);
+            });
+        }
+        copied.init(8, 8, 1, 2, 0);  // Reallocated for 3 layers
+        copied.fromCpu(layers);
+        REQUIRE(copied.getLayerCount() == 3);
+        REQUIRE(copied.getLevelCount() == 4);
+        copied.generateMipmaps();
+        REQUIRE(copied.toCpu(2, 3)->at(0, 0, 0) == 20);
+        layers.back() = oglw::CpuImage<uint8_t>::Create(4, 8, 1);
+        REQUIRE_THROWS(copied.fromCpu(layers));
+    }
+
+    SECTION("GpuImage 3D") {
+        oglw::GlWindow win("Title");
+        std::vector<oglw::CpuImagePtr<float>> slices;
+        for (size_t i = 0; i < 4; i++) {
+            slices.push_back(oglw::CpuImage<float>::Create(8, 4, 1));
+            slices.back()->foreach ([&](size_t, size_t, size_t, float& v) {
+                v = static_cast<float>(i);
+            });
+        }
+        oglw::GpuImage3D<float> gpu_vol(8, 4, 1, 4, 0);
+        REQUIRE(gpu_vol.getLevelCount() == 4);
+        gpu_vol.fromCpu(slices);
+        REQUIRE(gpu_vol.getSliceCount() == 4);
+        REQUIRE(gpu_vol.toCpu(3)->at(7, 3, 0) == 3.f);
+
+        // Slices are also halved
+        gpu_vol.generateMipmaps();
+        REQUIRE(gpu_vol.toCpu(1, 1)->at(3, 1, 0) == Approx(2.5f));
+        REQUIRE(gpu_vol.toCpu(0, 2)->at(0, 0, 0) == Approx(1.5f));
+        REQUIRE_THROWS(gpu_vol.toCpu(1, 2));
+
+        oglw::GpuImage3D<float> copied = gpu_vol;
+        REQUIRE(copied.toCpu(1, 1)->at(0, 0, 0) == Approx(2.5f));
+        REQUIRE(copied.toCpu(2)->at(0, 0, 0) == 2.f);
+    }
+
+    SECTION("GpuImage Planar layout") {
+        oglw::GlWindow win("Title");
+        auto cpu_img1 = oglw::CpuImage<uint8_t>::Create(
+                10, 20, 3, size_t(0), oglw::ImageLayout::PLANAR);
+        SetAll(*cpu_img1);
+        oglw::GpuImagePtr<uint8_t> gpu_img = cpu_img1->toGpu();
+        oglw::CpuImagePtr<uint8_t> cpu_img2 = gpu_img->toCpu();
+        REQUIRE(cpu_img2->getLayout() == oglw::ImageLayout::INTERLEAVED);
+        REQUIRE(CheckAll(*cpu_img2));
+    }
 }
@@ -0,0 +1,191 @@
+#include "catch2/catch.hpp"
+
+#include <oglw/image_filter.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+template <typename T>
+void SetRandom(oglw::CpuImage<T>& img, float range) {
+    uint32_t seed = 12345;
+    img.foreach ([&](size_t, size_t, size_t, T& v) {
+        seed = seed * 1664525u + 1013904223u;
+        v = T(static_cast<float>(seed >> 8) / 16777216.f * range);
+    }, 1);
+}
+
+float ReadBorder(const oglw::CpuImage<float>& img, ptrdiff_t x, ptrdiff_t y,
+                 size_t z, oglw::BorderMode border) {
+    const ptrdiff_t w = static_cast<ptrdiff_t>(img.getWidth());
+    const ptrdiff_t h = static_cast<ptrdiff_t>(img.getHeight());
+    auto map = [&](ptrdiff_t i, ptrdiff_t n) {
+        while (i < 0 || n <= i) {
+            if (border == oglw::BorderMode::CLAMP) {
+                i = (i < 0) ? 0 : n - 1;
+            } else if (border == oglw::BorderMode::REFLECT) {
+                i = (i < 0) ? -i : 2 * (n - 1) - i;
+            } else if (border == oglw::BorderMode::WRAP) {
+                i = (i < 0) ? i + n : i - n;
+            } else {
+                return ptrdiff_t(-1);
+            }
+        }
+        return i;
+    };
+    const ptrdiff_t sx = map(x, w), sy = map(y, h);
+    if (sx < 0 || sy < 0) {
+        return 0.f;
+    }
+    return img.at(static_cast<size_t>(sx), static_cast<size_t>(sy), z);
+}
+
+// Straightforward 2D correlation
+oglw::CpuImage<float> ConvolveNaive(const oglw::CpuImage<float>& img,
+                                    const std::vector<float>& kernel,
+                                    size_t kw, size_t kh,
+                                    oglw::BorderMode border) {
+    oglw::CpuImage<float> dst(img.getWidth(), img.getHeight(),
+                              img.getDepth());
+    const ptrdiff_t rx = static_cast<ptrdiff_t>(kw / 2);
+    const ptrdiff_t ry = static_cast<ptrdiff_t>(kh / 2);
+    dst.foreach ([&](size_t x, size_t y, size_t z, float& v) {
+        v = 0.f;
+        for (ptrdiff_t j = -ry; j <= ry; j++) {
+            for (ptrdiff_t i = -rx; i <= rx; i++) {
+                const float k = kernel[static_cast<size_t>(j + ry) * kw +
+                                       static_cast<size_t>(i + rx)];
+                v += k * ReadBorder(img, static_cast<ptrdiff_t>(x) + i,
+                                    static_cast<ptrdiff_t>(y) + j, z, border);
+            }
+        }
+    }, 1);
+    return dst;
+}
+
+std::vector<float> Outer(const std::vector<float>& xs,
+                         const std::vector<float>& ys) {
+    std::vector<float> kernel;
+    for (float y : ys) {
+        for (float x : xs) {
+            kernel.push_back(x * y);
+        }
+    }
+    return kernel;
+}
+
+template <typename T1, typename T2>
+float MaxDiff(const T1& lhs, const T2& rhs) {
+    float diff = 0.f;
+    lhs.foreach ([&](size_t x, size_t y, size_t z, const float& v) {
+        diff = std::max(diff, std::abs(v - rhs.at(x, y, z)));
+    }, 1);
+    return diff;
+}
+
+}  // namespace
+
+// =============================================================================
+TEST_CASE("Image filter test") {
+    const oglw::BorderMode BORDERS[] = {
+            oglw::BorderMode::CLAMP, oglw::BorderMode::REFLECT,
+            oglw::BorderMode::WRAP, oglw::BorderMode::ZERO};
+
+    SECTION("Separable and 2D") {
+        oglw::CpuImage<float> img(37, 23, 3);
+        SetRandom(img, 1.f);
+        const std::vector<float> xs = {0.1f, -0.5f, 1.f, 0.25f, 0.3f};
+        const std::vector<float> ys = {0.2f, 0.7f, -0.1f};
+        for (auto border : BORDERS) {
+            const auto ref =
+                    ConvolveNaive(img, Outer(xs, ys), 5, 3, border);
+            auto sep = oglw::FilterSeparable(img, xs, ys, border);
+            REQUIRE(MaxDiff(ref, *sep) < 1e-5f);
+            auto conv = oglw::Convolve(img, Outer(xs, ys), 5, 3, border);
+            REQUIRE(MaxDiff(ref, *conv) < 1e-5f);
+        }
+    }
+
+    SECTION("Large image in parallel") {
+        oglw::CpuImage<float> img(300, 200, 4, 64);
+        SetRandom(img, 1.f);
+        const std::vector<float> kernel = oglw::GetGaussianKernel(1.5f);
+        const size_t k = kernel.size();
+        const auto ref = ConvolveNaive(img, Outer(kernel, kernel), k, k,
+                                       oglw::BorderMode::REFLECT);
+        auto blurred = oglw::GaussianBlur(img, 1.5f);
+        REQUIRE(MaxDiff(ref, *blurred) < 1e-5f);
+    }
+
+    SECTION("Kernel larger than image") {
+        oglw::CpuImage<float> img(3, 2, 1);
+        SetRandom(img, 1.f);
+        const std::vector<float> kernel(9, 1.f);
+        for (auto border : BORDERS) {
+            const auto ref = ConvolveNaive(img, Outer(kernel, kernel), 9, 9,
+                                           border);
+            auto sep = oglw::FilterSeparable(img, kernel, kernel, border);
+            REQUIRE(MaxDiff(ref, *sep) < 1e-4f);
+        }
+    }
+
+    SECTION("Box and Gaussian keep constant") {
+        oglw::CpuImage<uint8_t> img(50, 40, 3);
+        img.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 100; });
+        auto box = oglw::BoxBlur(img, 3);
+        auto gauss = oglw::GaussianBlur(img, 2.f, oglw::BorderMode::CLAMP);
+        box->foreach ([](size_t, size_t, size_t, uint8_t v) {
+            REQUIRE(v == 100);
+        }, 1);
+        gauss->foreach ([](size_t, size_t, size_t, uint8_t v) {
+            REQUIRE(v == 100);
+        }, 1);
+        auto zero = oglw::BoxBlur(img, 1, oglw::BorderMode::ZERO);
+        REQUIRE(zero->at(0, 0, 0) == 44);  // 100 * 4 / 9
+        REQUIRE(zero->at(5, 5, 0) == 100);
+    }
+
+    SECTION("Types and layouts") {
+        oglw::CpuImage<float> img(64, 48, 4);
+        SetRandom(img, 1.f);
+        auto ref = oglw::GaussianBlur(img, 1.f);
+
+        auto u8_ref = ref->convertTo<uint8_t>(255.f);
+        auto u8 = oglw::GaussianBlur(*img.convertTo<uint8_t>(255.f), 1.f);
+        auto half = oglw::GaussianBlur(*img.convertTo<oglw::Float16>(), 1.f);
+        size_t n_u8_diff = 0;
+        u8->foreach ([&](size_t x, size_t y, size_t z, uint8_t v) {
+            n_u8_diff += (1 < std::abs(v - u8_ref->at(x, y, z)));
+        }, 1);
+        REQUIRE(n_u8_diff == 0);
+        REQUIRE(MaxDiff(*ref, *half->convertTo<float>()) < 2e-3f);
+
+        oglw::CpuImage<float> planar = img;
+        planar.setLayout(oglw::ImageLayout::PLANAR);
+        auto planar_blurred = oglw::GaussianBlur(planar, 1.f);
+        REQUIRE(planar_blurred->getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(MaxDiff(*ref, *planar_blurred) == 0.f);
+    }
+
+    SECTION("Sobel") {
+        oglw::CpuImage<uint8_t> img(20, 10, 1);
+        img.foreach ([](size_t x, size_t y, size_t, uint8_t& v) {
+            v = static_cast<uint8_t>(x * 2 + y);
+        });
+        auto gx = oglw::Sobel(img, 1, 0);
+        auto gy = oglw::Sobel(img, 0, 1);
+        REQUIRE(gx->at(5, 5, 0) == 2.f * 2.f * 4.f);
+        REQUIRE(gy->at(5, 5, 0) == 2.f * 4.f);
+        REQUIRE(gx->at(0, 5, 0) == 0.f);  // Reflected
+        REQUIRE_THROWS(oglw::Sobel(img, 1, 1));
+    }
+
+    SECTION("Invalid kernels") {
+        oglw::CpuImage<float> img(4, 4, 1);
+        REQUIRE_THROWS(oglw::FilterSeparable(img, {1.f, 1.f}, {1.f}));
+        REQUIRE_THROWS(oglw::FilterSeparable(img, {}, {1.f}));
+        REQUIRE_THROWS(oglw::Convolve(img, {1.f, 1.f, 1.f}, 3, 3));
+        REQUIRE_THROWS(oglw::GaussianBlur(img, 0.f));
+    }
+}
@@ -0,0 +1,257 @@
+#include "catch2/catch.hpp"
+
+#include <oglw/image_transform.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+template <typename T>
+void SetIndex(oglw::CpuImage<T>& img) {
+    img.foreach ([&](size_t x, size_t y, size_t z, T& v) {
+        v = T(static_cast<float>((y * img.getWidth() + x) * 4 + z));
+    }, 1);
+}
+
+template <typename T1, typename T2, typename F>
+bool CheckMapped(const T1& src, const T2& dst, F map) {
+    bool ok = true;
+    src.foreach ([&](size_t x, size_t y, size_t z, const float& v) {
+        size_t dx, dy;
+        map(x, y, dx, dy);
+        ok &= (dst.at(dx, dy, z) == v);
+    }, 1);
+    return ok;
+}
+
+}  // namespace
+
+// =============================================================================
+TEST_CASE("Image transform test") {
+    const oglw::ResizeFilter FILTERS[] = {oglw::ResizeFilter::BILINEAR,
+                                          oglw::ResizeFilter::BICUBIC,
+                                          oglw::ResizeFilter::LANCZOS3};
+
+    SECTION("Resize same size") {
+        oglw::CpuImage<float> img(13, 7, 3);
+        SetIndex(img);
+        for (auto filter : FILTERS) {
+            auto resized = oglw::Resize(img, 13, 7, filter);
+            REQUIRE(CheckMapped(img, *resized,
+                                [](size_t x, size_t y, size_t& dx,
+                                   size_t& dy) {
+                                    dx = x;
+                                    dy = y;
+                                }));
+        }
+    }
+
+    SECTION("Resize linear ramp") {
+        oglw::CpuImage<float> img(64, 40, 1);
+        img.foreach ([](size_t x, size_t y, size_t, float& v) {
+            v = static_cast<float>(x) * 2.f + static_cast<float>(y);
+        });
+        // Half: each pixel covers two source pixels
+        auto half = oglw::Resize(img, 32, 20);
+        REQUIRE(half->at(10, 5, 0) == Approx((10 * 2 + 0.5f) * 2.f +
+                                             (5 * 2 + 0.5f)));
+        // Double: pixel centers at quarters. Lanczos is not exact for ramps.
+        for (auto filter : FILTERS) {
+            auto twice = oglw::Resize(img, 128, 80, filter);
+            const float margin =
+                    (filter == oglw::ResizeFilter::LANCZOS3) ? 0.1f : 1e-3f;
+            REQUIRE(twice->at(41, 31, 0) ==
+                    Approx((41 * 0.5f - 0.25f) * 2.f + (31 * 0.5f - 0.25f))
+                            .margin(margin));
+        }
+    }
+
+    SECTION("Resize types and layouts") {
+        oglw::CpuImage<uint8_t> img(300, 200, 4);
+        img.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 77; });
+        for (auto filter : FILTERS) {
+            auto small = oglw::Resize(img, 45, 31, filter);
+            REQUIRE(small->getWidth() == 45);
+            small->foreach ([](size_t, size_t, size_t, uint8_t v) {
+                REQUIRE(v == 77);
+            });
+        }
+        oglw::CpuImage<float> f_img(90, 70, 3);
+        SetIndex(f_img);
+        auto ref = oglw::Resize(f_img, 50, 101, oglw::ResizeFilter::BICUBIC);
+        oglw::CpuImage<float> planar = f_img;
+        planar.setLayout(oglw::ImageLayout::PLANAR);
+        auto planar_resized =
+                oglw::Resize(planar, 50, 101, oglw::ResizeFilter::BICUBIC);
+        REQUIRE(planar_resized->getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(CheckMapped(*ref, *planar_resized,
+                            [](size_t x, size_t y, size_t& dx, size_t& dy) {
+                                dx = x;
+                                dy = y;
+                            }));
+        auto half = oglw::Resize(*f_img.convertTo<oglw::Float16>(), 50, 101,
+                                 oglw::ResizeFilter::BICUBIC);
+        half->convertTo<float>()->foreach (
+                [&](size_t x, size_t y, size_t z, float v) {
+                    REQUIRE(v == Approx(ref->at(x, y, z)).epsilon(2e-3));
+                },
+                1);
+        REQUIRE(oglw::Resize(f_img, 0, 10)->empty());
+    }
+
+    SECTION("Resize depths") {
+        // Each channel is the same as a single-channel plane, in all tails of
+        // vectorized pixels
+        for (size_t d : {1u, 2u, 3u, 4u, 5u}) {
+            oglw::CpuImage<float> img(37, 23, d);
+            SetIndex(img);
+            oglw::CpuImage<float> planar = img;
+            planar.setLayout(oglw::ImageLayout::PLANAR);
+            for (size_t w : {19u, 61u}) {
+                auto resized = oglw::Resize(img, w, 11);
+                auto planar_resized = oglw::Resize(planar, w, 11);
+                REQUIRE(CheckMapped(*resized, *planar_resized,
+                                    [](size_t x, size_t y, size_t& dx,
+                                       size_t& dy) {
+                                        dx = x;
+                                        dy = y;
+                                    }));
+            }
+        }
+    }
+
+    SECTION("Transpose and rotate") {
+        for (size_t d : {1u, 2u, 3u, 4u, 5u}) {
+            // Larger than a block, and not a multiple of it
+            oglw::CpuImage<float> img(70, 45, d, 16);
+            SetIndex(img);
+            const size_t w = img.getWidth(), h = img.getHeight();
+            auto transposed = oglw::Transpose(img);
+            REQUIRE(transposed->getWidth() == h);
+            REQUIRE(CheckMapped(img, *transposed,
+                                [](size_t x, size_t y, size_t& dx,
+                                   size_t& dy) {
+                                    dx = y;
+                                    dy = x;
+                                }));
+            REQUIRE(CheckMapped(img, *oglw::Rotate90(img, 1),
+                                [&](size_t x, size_t y, size_t& dx,
+                                    size_t& dy) {
+                                    dx = h - 1 - y;
+                                    dy = x;
+                                }));
+            REQUIRE(CheckMapped(img, *oglw::Rotate90(img, 2),
+                                [&](size_t x, size_t y, size_t& dx,
+                                    size_t& dy) {
+                                    dx = w - 1 - x;
+                                    dy = h - 1 - y;
+                                }));
+            REQUIRE(CheckMapped(img, *oglw::Rotate90(img, -1),
+                                [&](size_t x, size_t y, size_t& dx,
+                                    size_t& dy) {
+                                    dx = y;
+                                    dy = w - 1 - x;
+                                }));
+            REQUIRE(CheckMapped(img, *oglw::Rotate90(img, 4),
+                                [](size_t x, size_t y, size_t& dx,
+                                   size_t& dy) {
+                                    dx = x;
+                                    dy = y;
+                                }));
+        }
+
+        oglw::CpuImage<uint8_t> u8_img(33, 65, 3);
+        u8_img.foreach ([](size_t x, size_t y, size_t z, uint8_t& v) {
+            v = static_cast<uint8_t>(x + y * 3 + z);
+        });
+        auto u8_rotated = oglw::Rotate90(*oglw::Rotate90(u8_img, 1), 3);
+        REQUIRE(std::equal(u8_img.data(), u8_img.data() + 33 * 65 * 3,
+                           u8_rotated->data()));
+
+        oglw::CpuImage<float> planar(20, 10, 3, 0, oglw::ImageLayout::PLANAR);
+        SetIndex(planar);
+        auto planar_rotated = oglw::Rotate90(planar, 1);
+        REQUIRE(planar_rotated->getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(CheckMapped(planar, *planar_rotated,
+                            [](size_t x, size_t y, size_t& dx, size_t& dy) {
+                                dx = 10 - 1 - y;
+                                dy = x;
+                            }));
+    }
+
+    SECTION("Mipmaps") {
+        oglw::CpuImage<uint8_t> img(64, 20, 3);
+        img.foreach ([](size_t, size_t, size_t, uint8_t& v) { v = 90; });
+        for (auto filter : {oglw::ResizeFilter::BOX,
+                            oglw::ResizeFilter::KAISER}) {
+            auto levels = oglw::BuildMipmaps(img, filter);
+            REQUIRE(levels.size() == 7);
+            const auto& level0 = *levels[0];
+            const auto& const_img = img;
+            REQUIRE(level0.data() == const_img.data());  // Shared
+            REQUIRE(levels[3]->getWidth() == 8);
+            REQUIRE(levels[3]->getHeight() == 2);
+            REQUIRE(levels[6]->getWidth() == 1);
+            REQUIRE(levels[6]->getHeight() == 1);
+            for (auto& level : levels) {
+                level->foreach ([](size_t, size_t, size_t, uint8_t v) {
+                    REQUIRE(v == 90);
+                });
+            }
+        }
+        REQUIRE(oglw::BuildMipmaps(img, oglw::ResizeFilter::BOX, 2).size() ==
+                2);
+
+        // Halving is same as generic box resize
+        oglw::CpuImage<float> f_img(40, 24, 4);
+        SetIndex(f_img);
+        auto levels = oglw::BuildMipmaps(f_img);
+        REQUIRE(levels[1]->at(3, 2, 1) ==
+                (f_img.at(6, 4, 1) + f_img.at(7, 4, 1) + f_img.at(6, 5, 1) +
+                 f_img.at(7, 5, 1)) * 0.25f);
+        for (size_t level = 1; level < levels.size(); level++) {
+            const auto& prev = *levels[level - 1];
+            auto ref = oglw::Resize(prev, levels[level]->getWidth(),
+                                    levels[level]->getHeight(),
+                                    oglw::ResizeFilter::BOX);
+            levels[level]->foreach ([&](size_t x, size_t y, size_t z,
+                                        float v) {
+                REQUIRE(v == Approx(ref->at(x, y, z)));
+            }, 1);
+        }
+        oglw::CpuImage<float> planar = f_img;
+        planar.setLayout(oglw::ImageLayout::PLANAR);
+        auto planar_levels = oglw::BuildMipmaps(planar);
+        REQUIRE(planar_levels[2]->getLayout() == oglw::ImageLayout::PLANAR);
+        REQUIRE(CheckMapped(*levels[2], *planar_levels[2],
+                            [](size_t x, size_t y, size_t& dx, size_t& dy) {
+                                dx = x;
+                                dy = y;
+                            }));
+        REQUIRE_THROWS(oglw::BuildMipmaps(oglw::CpuImage<float>()));
+    }
+
+    SECTION("Flip vertical") {
+        for (size_t h : {1u, 6u, 7u}) {
+            oglw::CpuImage<float> img(5, h, 3, 64);
+            SetIndex(img);
+            oglw::CpuImage<float> flipped = img;
+            oglw::FlipVertical(flipped);
+            REQUIRE(CheckMapped(img, flipped,
+                                [&](size_t x, size_t y, size_t& dx,
+                                    size_t& dy) {
+                                    dx = x;
+                                    dy = h - 1 - y;
+                                }));
+            flipped.setLayout(oglw::ImageLayout::PLANAR);
+            oglw::FlipVertical(flipped);
+            REQUIRE(CheckMapped(img, flipped,
+                                [](size_t x, size_t y, size_t& dx,
+                                   size_t& dy) {
+                                    dx = x;
+                                    dy = y;
+                                }));
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "catch2/catch.hpp"
+
+#include <oglw/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Parallel test") {
+    SECTION("Cover all indices") {
+        for (size_t n_worker : {0u, 1u, 3u, 100u}) {
+            const size_t N = 1000;
+            std::vector<std::atomic<int>> cnts(N);
+            oglw::ParallelFor(N,
+                              [&](size_t begin, size_t end) {
+                                  for (size_t i = begin; i < end; i++) {
+                                      cnts[i]++;
+                                  }
+                              },
+                              n_worker);
+            for (size_t i = 0; i < N; i++) {
+                REQUIRE(cnts[i] == 1);
+            }
+        }
+    }
+
+    SECTION("Nested") {
+        std::atomic<size_t> sum(0);
+        oglw::ParallelFor(10, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                oglw::ParallelFor(10, [&](size_t b, size_t e) {
+                    sum += e - b;
+                });
+            }
+        });
+        REQUIRE(sum == 100);
+    }
+
+    SECTION("Exception") {
+        REQUIRE_THROWS_AS(oglw::ParallelFor(100,
+                                            [](size_t begin, size_t) {
+                                                if (begin == 0) {
+                                                    throw std::runtime_error(
+                                                            "error");
+                                                }
+                                            }),
+                          std::runtime_error);
+        // Still usable
+        std::atomic<size_t> sum(0);
+        oglw::ParallelFor(100, [&](size_t b, size_t e) { sum += e - b; });
+        REQUIRE(sum == 100);
+    }
+
+    SECTION("Workers") {
+        oglw::SetParallelWorkers(2, {0});
+        REQUIRE(oglw::GetParallelWorkerCount() == 2);
+        std::atomic<size_t> sum(0);
+        oglw::ParallelFor(100, [&](size_t b, size_t e) { sum += e - b; });
+        REQUIRE(sum == 100);
+        // Default
+        oglw::SetParallelWorkers(0);
+        REQUIRE(1 <= oglw::GetParallelWorkerCount());
+    }
+
+    SECTION("Pinned") {
+        // Each range is always run by the same worker
+        oglw::SetParallelWorkers(3, {0});
+        REQUIRE(oglw::HasParallelAffinity());
+        const size_t N = 100;
+        std::vector<std::thread::id> ids1(N), ids2(N);
+        for (auto* ids : {&ids1, &ids2}) {
+            oglw::ParallelForPinned(N, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    (*ids)[i] = std::this_thread::get_id();
+                }
+            });
+        }
+        REQUIRE(ids1 == ids2);
+        std::vector<std::thread::id> workers = ids1;
+        std::sort(workers.begin(), workers.end());
+        workers.erase(std::unique(workers.begin(), workers.end()),
+                      workers.end());
+        REQUIRE(workers.size() == 3);
+        REQUIRE(std::count(ids1.begin(), ids1.end(),
+                           std::this_thread::get_id()) == 0);
+
+        // Nested and unbound ones are not pinned
+        std::atomic<size_t> sum(0);
+        oglw::ParallelForPinned(10, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                oglw::ParallelForPinned(10, [&](size_t b, size_t e) {
+                    sum += e - b;
+                });
+            }
+        });
+        REQUIRE(sum == 100);
+        oglw::SetParallelWorkers(0);
+        REQUIRE(!oglw::HasParallelAffinity());
+        oglw::ParallelForPinned(10, [&](size_t b, size_t e) { sum += e - b; });
+        REQUIRE(sum == 110);
+    }
+}